@@ -1,27 +1,37 @@
 #!python3
 import argparse
 import os
-import logging
+import os.path as path
+import toml
+
+from results import read_text
 
 global args
 
 parser = argparse.ArgumentParser()
 parser.add_argument("-d", "--dir", type=str, help="Input dir to be reduce")
+parser.add_argument("-j", "--jobs", type=int, default=0,
+                    help="Candidates checked concurrently (0: all cores)")
 
 if __name__ == "__main__":
     args = parser.parse_args()
     mo_dir = os.path.split(os.path.split(__file__)[0])[0]
     mo_build_dir = os.path.join(mo_dir, "build")
-    reduce_oracle = os.path.join(mo_dir, "scripts", "reduce_driver.sh")
+    moreduce = os.path.join(mo_build_dir, "moreduce")
 
     better_dir = os.path.join(args.dir, "better")
     original_ir = os.path.join(args.dir, "original.ll")
+    config = toml.load([path.join(mo_dir, "config", "default.toml"),
+                        path.join(args.dir, "config.toml")])
 
     for d in os.listdir(better_dir):
         output_dir = os.path.join(better_dir, d, "reduced")
-        with open(os.path.join(better_dir, d, "func_name")) as f:
-            func_name = f.read().strip()
+        func_name = read_text(os.path.join(better_dir, d, "func_name"))
+        if func_name:
             os.system(
-                f"llvm-reduce -test={reduce_oracle} --test-arg={mo_build_dir} \
-                --test-arg=\"{func_name}\" --test-arg={output_dir} --test-arg={args.dir} \
-                {original_ir} --ir-passes=helloworld")
+                f"{moreduce} -reduce {original_ir} -func=\"{func_name}\" \
+                -seed={args.dir}/seed -pipeline={args.dir}/pipeline \
+                -pipeline-type={config['mutate']['type']} \
+                -original-opt={config['optimize']['original']} \
+                -mutant-opt={config['optimize']['mutant']} \
+                -j={args.jobs} -o {output_dir}")
@@ -6,10 +6,14 @@ import multiprocessing
 from tqdm import tqdm
 from multiprocessing import Pool
 
+# Each reduction checks this many candidates concurrently, so that the last few
+# big cases still keep all cores busy.
+jobs_per_case = 4
+
 
 def reduce(dir_to_reduce):
     reducer = os.path.join(os.path.split(__file__)[0], "moreduce.py")
-    return os.system(f"python3 {reducer} -d {dir_to_reduce} >/dev/null 2>&1")
+    return os.system(f"python3 {reducer} -d {dir_to_reduce} -j {jobs_per_case} >/dev/null 2>&1")
 
 
 def cleanup():
@@ -22,6 +26,6 @@ if __name__ == "__main__":
     dir_to_reduce = sys.argv[1]
     dirs_to_reduce = [os.path.join(dir_to_reduce, dirname)
                       for dirname in os.listdir(dir_to_reduce)]
-    with Pool() as p:
+    with Pool(max(1, multiprocessing.cpu_count() // jobs_per_case)) as p:
         result = list(tqdm(p.imap_unordered(
             reduce, dirs_to_reduce), total=len(dirs_to_reduce)))
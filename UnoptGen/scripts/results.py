@@ -0,0 +1,277 @@
+#!/bin/python3
+"""Results of a campaign, in a single SQLite file next to the findings.
+
+Every worker appends to the same database: SQLite in WAL mode lets readers
+run alongside one writer, and writers wait for each other instead of failing.
+The directory of a finding is named by its row id, so workers never race for
+an index.
+
+    results.py DB query --by static_profile --status pending -n 100
+    results.py DB clusters <file written by mocluster -o>
+    results.py DB mark <finding dir> --status reduced
+"""
+import argparse
+import hashlib
+import os
+import sqlite3
+import subprocess
+import sys
+import time
+from os import path
+
+SCHEMA = """
+CREATE TABLE IF NOT EXISTS findings (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    kind TEXT NOT NULL,
+    source_path TEXT,
+    input_hash TEXT,
+    seed TEXT,
+    pipeline TEXT,
+    config TEXT,
+    dir TEXT,
+    func_name TEXT,
+    stage TEXT,
+    diff_signature TEXT,
+    cluster_id INTEGER,
+    reduction_status TEXT NOT NULL DEFAULT 'pending',
+    created REAL NOT NULL
+);
+CREATE TABLE IF NOT EXISTS scores (
+    finding_id INTEGER NOT NULL REFERENCES findings(id) ON DELETE CASCADE,
+    indicator TEXT NOT NULL,
+    value REAL NOT NULL,
+    PRIMARY KEY (finding_id, indicator)
+);
+CREATE TABLE IF NOT EXISTS inputs (
+    input_hash TEXT PRIMARY KEY,
+    source_path TEXT,
+    runs INTEGER NOT NULL DEFAULT 0,
+    opt_seconds REAL NOT NULL DEFAULT 0,
+    novel_mutants INTEGER NOT NULL DEFAULT 0
+);
+CREATE TABLE IF NOT EXISTS mutants (
+    input_hash TEXT NOT NULL,
+    mutant_hash TEXT NOT NULL,
+    PRIMARY KEY (input_hash, mutant_hash)
+);
+CREATE INDEX IF NOT EXISTS findings_kind ON findings(kind);
+CREATE INDEX IF NOT EXISTS findings_input_hash ON findings(input_hash);
+CREATE INDEX IF NOT EXISTS findings_dir ON findings(dir);
+CREATE INDEX IF NOT EXISTS findings_signature ON findings(diff_signature);
+CREATE INDEX IF NOT EXISTS findings_cluster ON findings(cluster_id);
+CREATE INDEX IF NOT EXISTS findings_status ON findings(reduction_status);
+CREATE INDEX IF NOT EXISTS scores_indicator ON scores(indicator, value);
+"""
+
+REDUCTION_STATUSES = ["pending", "reducing", "reduced", "failed"]
+
+moblob = path.join(path.dirname(path.dirname(path.abspath(__file__))),
+                   "build", "moblob")
+
+
+def hash_file(file_path):
+    with open(file_path, "rb") as f:
+        return hashlib.sha256(f.read()).hexdigest()
+
+
+def read_text(file_path):
+    """Read a file of a case, through the blob store if moblob packed it."""
+    if not path.exists(file_path):
+        return None
+    with open(file_path) as f:
+        text = f.read().strip()
+    if text.startswith("blob:") and len(text) <= 64 and " " not in text:
+        p = subprocess.run([moblob, "get", text], stdout=subprocess.PIPE,
+                           encoding="utf-8")
+        if p.returncode != 0:
+            return None
+        text = p.stdout.strip()
+    return text
+
+
+def parse_scores(file_path):
+    """Read the scores written by `moclassify -scores`, by function."""
+    scores = {}
+    if not path.exists(file_path):
+        return scores
+    with open(file_path) as f:
+        for line in f:
+            fields = line.split()
+            if not fields:
+                continue
+            func_scores = scores.setdefault(fields[0], {})
+            for field in fields[1:]:
+                name, value = field.split("=", 1)
+                func_scores[name] = float(value)
+    return scores
+
+
+class ResultsDB:
+    def __init__(self, db_path):
+        # Writers of other workers hold the lock for milliseconds; wait for
+        # them rather than failing.
+        self.conn = sqlite3.connect(db_path, timeout=60, isolation_level=None)
+        self.conn.execute("PRAGMA journal_mode=WAL")
+        self.conn.execute("PRAGMA synchronous=NORMAL")
+        self.conn.execute("PRAGMA foreign_keys=ON")
+        self.conn.executescript(SCHEMA)
+        self.migrate()
+
+    def migrate(self):
+        """Bring databases of older campaigns up to the schema."""
+        columns = [row[1] for row in
+                   self.conn.execute("PRAGMA table_info(findings)")]
+        if "stage" not in columns:
+            # Crashes used to keep their stage in func_name.
+            self.conn.execute("ALTER TABLE findings ADD COLUMN stage TEXT")
+            self.conn.execute(
+                "UPDATE findings SET stage = func_name, func_name = NULL "
+                "WHERE kind = 'crashed'")
+
+    def close(self):
+        self.conn.close()
+
+    def add_finding(self, kind, **fields):
+        """Append a finding and return its id."""
+        fields["kind"] = kind
+        fields["created"] = time.time()
+        names = ", ".join(fields)
+        marks = ", ".join("?" for _ in fields)
+        cur = self.conn.execute(
+            f"INSERT INTO findings ({names}) VALUES ({marks})",
+            list(fields.values()))
+        return cur.lastrowid
+
+    def update_finding(self, finding_id, **fields):
+        sets = ", ".join(f"{name} = ?" for name in fields)
+        self.conn.execute(f"UPDATE findings SET {sets} WHERE id = ?",
+                          list(fields.values()) + [finding_id])
+
+    def add_scores(self, finding_id, scores):
+        self.conn.executemany(
+            "INSERT OR REPLACE INTO scores VALUES (?, ?, ?)",
+            [(finding_id, name, value) for name, value in scores.items()])
+
+    def add_mutant(self, input_hash, mutant_hash):
+        """Remember a mutant of an input; return whether it is a new one."""
+        cur = self.conn.execute(
+            "INSERT OR IGNORE INTO mutants VALUES (?, ?)",
+            (input_hash, mutant_hash))
+        return cur.rowcount > 0
+
+    def record_run(self, input_hash, source_path, opt_seconds, novel):
+        """Add a run of an input to its history."""
+        self.conn.execute(
+            "INSERT INTO inputs VALUES (?, ?, 1, ?, ?) "
+            "ON CONFLICT(input_hash) DO UPDATE SET "
+            "source_path = excluded.source_path, runs = runs + 1, "
+            "opt_seconds = opt_seconds + excluded.opt_seconds, "
+            "novel_mutants = novel_mutants + excluded.novel_mutants",
+            (input_hash, source_path, opt_seconds, int(novel)))
+
+    def input_history(self):
+        """Runs, optimization time, novel mutants, findings, reduced findings
+        and distinct diff signatures of every input that has run, by hash."""
+        rows = self.conn.execute(
+            "SELECT i.input_hash, i.runs, i.opt_seconds, i.novel_mutants, "
+            "COUNT(f.id), COUNT(CASE WHEN f.reduction_status = 'reduced' "
+            "THEN 1 END), COUNT(DISTINCT f.diff_signature) "
+            "FROM inputs i LEFT JOIN findings f "
+            "ON f.input_hash = i.input_hash AND f.kind = 'missed-opt' "
+            "GROUP BY i.input_hash").fetchall()
+        names = ["runs", "opt_seconds", "novel_mutants", "findings",
+                 "reduced", "signatures"]
+        return {row[0]: dict(zip(names, row[1:])) for row in rows}
+
+    def count(self, kind):
+        return self.conn.execute(
+            "SELECT COUNT(*) FROM findings WHERE kind = ?",
+            (kind,)).fetchone()[0]
+
+    def set_status(self, finding_dir, status):
+        self.conn.execute(
+            "UPDATE findings SET reduction_status = ? WHERE dir = ?",
+            (status, path.abspath(finding_dir)))
+
+    def set_clusters(self, assignment):
+        """Record the clusters of `mocluster -o`, by finding directory."""
+        with self.conn:
+            self.conn.execute("BEGIN")
+            self.conn.executemany(
+                "UPDATE findings SET cluster_id = ? WHERE dir = ?",
+                [(cluster, path.abspath(finding_dir))
+                 for finding_dir, cluster in assignment])
+
+    def query(self, by=None, status=None, cluster=None, limit=100,
+              ascending=False):
+        """Findings with the highest score of an indicator first."""
+        conds = ["f.kind = 'missed-opt'"]
+        params = []
+        if status:
+            conds.append("f.reduction_status = ?")
+            params.append(status)
+        if cluster is not None:
+            conds.append("f.cluster_id = ?")
+            params.append(cluster)
+
+        if by:
+            order = "ASC" if ascending else "DESC"
+            sql = ("SELECT f.id, f.dir, f.func_name, f.reduction_status, "
+                   "f.cluster_id, s.value FROM findings f "
+                   "JOIN scores s ON s.finding_id = f.id AND s.indicator = ? "
+                   f"WHERE {' AND '.join(conds)} "
+                   f"ORDER BY s.value {order} LIMIT ?")
+            params = [by] + params
+        else:
+            sql = ("SELECT f.id, f.dir, f.func_name, f.reduction_status, "
+                   "f.cluster_id, NULL FROM findings f "
+                   f"WHERE {' AND '.join(conds)} ORDER BY f.id LIMIT ?")
+        return self.conn.execute(sql, params + [limit]).fetchall()
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("db", type=str, help="Results database")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    query = commands.add_parser("query", help="List findings")
+    query.add_argument("--by", type=str,
+                       help="Indicator to sort by, highest first")
+    query.add_argument("--ascending", action="store_true",
+                       help="Lowest scores first")
+    query.add_argument("--status", choices=REDUCTION_STATUSES,
+                       help="Only findings of this reduction status")
+    query.add_argument("--cluster", type=int,
+                       help="Only findings of this cluster")
+    query.add_argument("-n", "--limit", type=int, default=100)
+
+    clusters = commands.add_parser(
+        "clusters", help="Record the clusters written by mocluster -o")
+    clusters.add_argument("file", type=str)
+
+    mark = commands.add_parser("mark", help="Set the reduction status")
+    mark.add_argument("dirs", type=str, nargs="+")
+    mark.add_argument("--status", choices=REDUCTION_STATUSES, required=True)
+
+    args = parser.parse_args()
+    db = ResultsDB(args.db)
+
+    if args.command == "query":
+        for row in db.query(args.by, args.status, args.cluster, args.limit,
+                            args.ascending):
+            print(" ".join("-" if field is None else str(field)
+                           for field in row))
+    elif args.command == "clusters":
+        with open(args.file) as f:
+            assignment = [(fields[0], int(fields[1]))
+                          for fields in map(str.split, f) if fields]
+        db.set_clusters(assignment)
+    elif args.command == "mark":
+        for finding_dir in args.dirs:
+            db.set_status(finding_dir, args.status)
+
+    db.close()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
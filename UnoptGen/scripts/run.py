@@ -7,18 +7,22 @@ import argparse
 import tempfile
 import subprocess
 import logging
+import hashlib
+import time
+
+from results import ResultsDB, hash_file, parse_scores, read_text
+from schedule import BASE_ENERGY, schedule
 
 global unoptgen
 root_dir = path.split(path.split(__file__)[0])[0]
 unoptgen_build = path.join(root_dir, "build")
 unoptgen = path.join(root_dir, "build", "unoptgen")
 moclassify = path.join(root_dir, "build", "moclassify")
+moblob = path.join(root_dir, "build", "moblob")
+modiff = path.join(root_dir, "build", "mo-diff")
 
 global args
-global index_missed_better
-global index_crashed
-index_missed_better = 0
-index_crashed = 0
+global db
 
 logging.basicConfig(
     level=logging.DEBUG,
@@ -47,6 +51,33 @@ parser.add_argument(
     required=True,
 )
 
+parser.add_argument(
+    "--blob-store",
+    type=str,
+    help="pack the files of every result into this blob store",
+)
+
+parser.add_argument(
+    "--db",
+    type=str,
+    help="results database, <output>/results.db by default",
+)
+
+parser.add_argument(
+    "--schedule",
+    choices=["energy", "fixed"],
+    default="energy",
+    help="checks of every input: by its history in the database (energy), "
+    "or the same for all in directory order (fixed)",
+)
+
+parser.add_argument(
+    "--checks-per-file",
+    type=int,
+    default=BASE_ENERGY,
+    help="checks of every input, or of an average one with --schedule=energy",
+)
+
 
 def mutate(original_path, mutant_path, working_dir, config):
     success = os.system(
@@ -55,12 +86,54 @@ def mutate(original_path, mutant_path, working_dir, config):
     return success
 
 
-def mine(original_path, config_path):
+def case_fields(original_path, working_dir, config_path):
+    return {
+        "source_path": path.abspath(original_path),
+        "input_hash": hash_file(original_path),
+        "seed": read_text(path.join(working_dir, "seed")),
+        "pipeline": read_text(path.join(working_dir, "pipeline")),
+        "config": path.abspath(config_path),
+    }
+
+
+def record_crash(original_path, working_dir, stage):
+    crash_id = db.add_finding(
+        "crashed", stage=stage,
+        **case_fields(original_path, working_dir, args.config))
+    crash_dir = path.join(args.output, "crashed", str(crash_id))
+    os.system(f"mv {working_dir} {crash_dir}")
+    db.update_finding(crash_id, dir=path.abspath(crash_dir))
+
+
+def diff_signature(missed_dir, config, func):
+    """Hash of the instruction diff of func put by mo-diff."""
+    pipeline = config["pipeline"][0]
+    p = subprocess.run(
+        [modiff,
+         path.join(missed_dir, config["optimized_original_name"]),
+         path.join(missed_dir, pipeline["optimized_mutant_name"]),
+         "-func", func],
+        stdout=subprocess.PIPE)
+    if p.returncode != 0:
+        return None
+    return hashlib.sha1(p.stdout).hexdigest()
+
+
+def timed_run(stats, *popenargs, **kwargs):
+    """subprocess.run, adding the time it takes to stats["opt_seconds"]."""
+    start = time.monotonic()
+    ret = subprocess.run(*popenargs, **kwargs)
+    stats["opt_seconds"] += time.monotonic() - start
+    return ret
+
+
+def mine(original_path, config_path, stats):
+    """Check a mutant of original_path. Put the time of the optimizations and
+    whether the mutant is a new one into stats."""
     working_dir = tempfile.mkdtemp()
     default_config_path = path.join(root_dir, "config", "default.toml")
     config = toml.load([default_config_path, config_path])
 
-    global index_crashed
     # Mutate IR
     os.system(f"cp {original_path} {working_dir}/original.ll")
     os.system(f"cp {config_path} {working_dir}/config.toml")
@@ -81,14 +154,16 @@ def mine(original_path, config_path):
 
         if ret.returncode != 0:
             logging.error(f"UnoptGen crashed when mutating {original_path}")
-            crash_dir = path.join(
-                args.output, "crashed", str(index_crashed))
-            os.system(f"mv {working_dir} {crash_dir}")
-            logging.error(f"Mutated {original_path} crashed opt")
-            index_crashed += 1
+            record_crash(original_path, working_dir, "unoptgen")
             return
 
-        ret = subprocess.run(
+        if functions is None:
+            stats["novel"] = db.add_mutant(
+                hash_file(original_path),
+                hash_file(path.join(working_dir, pipeline["mutant_name"])))
+
+        ret = timed_run(
+            stats,
             [
                 "opt", "-S", config["optimize"]["mutant"],
                 path.join(working_dir, pipeline["mutant_name"]),
@@ -97,14 +172,12 @@ def mine(original_path, config_path):
             ])
 
         if ret.returncode != 0:
-            crash_dir = path.join(
-                args.output, "crashed", str(index_crashed))
-            os.system(f"mv {working_dir} {crash_dir}")
             logging.error(f"Mutated {original_path} crashed opt")
-            index_crashed += 1
+            record_crash(original_path, working_dir, "opt-mutant")
             return
 
-        ret = subprocess.run(
+        ret = timed_run(
+            stats,
             [
                 "opt", "-S", config["optimize"]["original"],
                 path.join(working_dir, "original.ll"),
@@ -112,17 +185,17 @@ def mine(original_path, config_path):
                                 config["optimized_original_name"])
             ])
         if ret.returncode != 0:
-            crash_dir = path.join(
-                args.output, "crashed", str(index_crashed))
-            os.system(f"mv {working_dir} {crash_dir}")
             logging.error(f"Original {original_path} crashed opt")
-            index_crashed += 1
+            record_crash(original_path, working_dir, "opt-original")
             return
 
         p = subprocess.Popen(
             [moclassify,
              path.join(working_dir, pipeline["optimized_mutant_name"]),
              path.join(working_dir, config["optimized_original_name"]),
+             "-scores", path.join(working_dir,
+                                  pipeline["name"] + ".scores"),
+             "-indicators=" + config["classify"]["indicators"],
              ] + (["-reverse"] if pipeline["reverse_check"] else []),
             stdout=subprocess.PIPE,
             encoding='utf-8')
@@ -139,15 +212,25 @@ def mine(original_path, config_path):
     if functions is None or len(functions) == 0:
         return
 
-    global index_missed_better
-    missed_dir = path.join(
-        args.output, "missed-opt", str(index_missed_better))
+    # The case is named by the row of its first finding.
+    fields = case_fields(original_path, working_dir, config_path)
+    ids = [db.add_finding("missed-opt", func_name=func, **fields)
+           for func in functions]
+    missed_dir = path.join(args.output, "missed-opt", str(ids[0]))
     os.system(f"mv {working_dir} {missed_dir}")
     os.system(f"echo {original_path} > {missed_dir}/source_path.txt")
-    index_missed_better += 1
+
+    scores = {}
+    for pipeline in config["pipeline"]:
+        prefix = "" if len(config["pipeline"]) == 1 else pipeline["name"] + "."
+        pipeline_scores = parse_scores(
+            path.join(missed_dir, pipeline["name"] + ".scores"))
+        for func, func_scores in pipeline_scores.items():
+            for name, value in func_scores.items():
+                scores.setdefault(func, {})[prefix + name] = value
 
     i = 0
-    for func in functions:
+    for finding_id, func in zip(ids, functions):
         func_path = path.join(missed_dir, str(i))
         os.system(f"mkdir -p {func_path}")
         os.system(f"echo {func} > {func_path}/func_name")
@@ -165,36 +248,55 @@ def mine(original_path, config_path):
                  "--func", func,
                  "-o", path.join(func_path, pipeline["optimized_mutant_name"])])
 
+        db.update_finding(finding_id, dir=path.abspath(func_path),
+                          diff_signature=diff_signature(
+                              missed_dir, config, func))
+        db.add_scores(finding_id, scores.get(func, {}))
         i += 1
 
+    if args.blob_store:
+        ret = subprocess.run(
+            [moblob, "pack", missed_dir, "-blob-store", args.blob_store])
+        if ret.returncode != 0:
+            logging.error(f"Cannot pack {missed_dir} into the blob store")
+
 
 if __name__ == "__main__":
     args = parser.parse_args()
 
     os.makedirs(path.join(args.output, "missed-opt"), exist_ok=True)
     os.makedirs(path.join(args.output, "crashed"), exist_ok=True)
+    db = ResultsDB(args.db or path.join(args.output, "results.db"))
 
     os.system(f"cp {args.config} {args.output}/config.toml")
 
-    check_per_file = 3
-    total_checks = 0
-    cur_checks = 0
-
+    inputs = []
     for root, _, filenames in os.walk(args.input):
         for filename in filenames:
             if filename.endswith(".ll"):
-                total_checks += check_per_file
+                file_path = path.join(root, filename)
+                inputs.append((file_path, hash_file(file_path)))
 
-    for root, _, filenames in os.walk(args.input):
-        for filename in filenames:
-            for i in range(check_per_file):
-                if filename.endswith(".ll"):
-                    mine(path.join(root, filename), args.config)
-                    cur_checks += 1
-                    print(
-                        f"\rProgress: [{cur_checks}/{total_checks}],  Found: {index_missed_better}")
-                    sys.stdout.flush()
+    if args.schedule == "energy":
+        plan = schedule(inputs, db.input_history(), args.checks_per_file)
+    else:
+        plan = [(file_path, args.checks_per_file) for file_path, _ in inputs]
+    input_hashes = dict(inputs)
+
+    total_checks = sum(checks for _, checks in plan)
+    cur_checks = 0
+
+    for file_path, checks in plan:
+        for i in range(checks):
+            stats = {"opt_seconds": 0.0, "novel": False}
+            mine(file_path, args.config, stats)
+            db.record_run(input_hashes[file_path], path.abspath(file_path),
+                          stats["opt_seconds"], stats["novel"])
+            cur_checks += 1
+            print(
+                f"\rProgress: [{cur_checks}/{total_checks}],  Found: {db.count('missed-opt')}")
+            sys.stdout.flush()
 
     print("=======Result=======")
-    print(f"Found {index_missed_better} candidates")
-    print(f"Found {index_crashed} crashed cases")
+    print(f"Found {db.count('missed-opt')} candidates")
+    print(f"Found {db.count('crashed')} crashed cases")
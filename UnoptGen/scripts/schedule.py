@@ -0,0 +1,60 @@
+#!/bin/python3
+"""Energy of the inputs of a campaign, like the power schedules of AFL.
+
+Every input gets a number of checks, its energy, from its history in the
+results database: it grows with the findings of the input, the distinct diff
+signatures among them and the rate of mutants never seen before, and shrinks
+with the time spent optimizing it. Inputs that never ran get the energy of an
+average input and go first, and every input gets at least one check, so
+unproductive inputs are still explored. The history is in the database, so it
+survives restarts.
+"""
+
+# Checks of an input as productive and as cheap as the mean one
+BASE_ENERGY = 3
+MIN_ENERGY = 1
+MAX_ENERGY = 16
+
+# Worth of a finding, of a reduced one on top, and of a new diff signature
+FINDING_WEIGHT = 1.0
+REDUCED_WEIGHT = 2.0
+SIGNATURE_WEIGHT = 2.0
+
+# Bounds of the factor for being cheaper or dearer than the mean input
+MAX_COST_FACTOR = 4.0
+
+
+def energy(history, mean_cost, base=BASE_ENERGY):
+    """Checks to give to an input, whose history is None if it never ran."""
+    if history is None or history["runs"] == 0:
+        return base
+
+    runs = history["runs"]
+    productivity = (FINDING_WEIGHT * history["findings"] +
+                    REDUCED_WEIGHT * history["reduced"] +
+                    SIGNATURE_WEIGHT * history["signatures"]) / runs
+    novelty = history["novel_mutants"] / runs
+
+    cost = history["opt_seconds"] / runs
+    # Runs that stopped before any optimization, e.g. when the mutator
+    # crashed, tell nothing about the cost.
+    cost_factor = mean_cost / cost if cost > 0 and mean_cost > 0 else 1
+    cost_factor = min(max(cost_factor, 1 / MAX_COST_FACTOR), MAX_COST_FACTOR)
+
+    # An input whose mutants all repeat earlier ones gets half the energy.
+    value = base * (1 + productivity) * (0.5 + 0.5 * novelty) * cost_factor
+    return int(min(max(round(value), MIN_ENERGY), MAX_ENERGY))
+
+
+def schedule(inputs, histories, base=BASE_ENERGY):
+    """Order (path, input hash) pairs, the new inputs and then the others by
+    energy, highest first, and return (path, checks) pairs."""
+    runs = sum(h["runs"] for h in histories.values())
+    seconds = sum(h["opt_seconds"] for h in histories.values())
+    mean_cost = seconds / runs if runs else 0
+
+    planned = [(input_hash in histories, file_path,
+                energy(histories.get(input_hash), mean_cost, base))
+               for file_path, input_hash in inputs]
+    planned.sort(key=lambda plan: (plan[0], -plan[2]))
+    return [(file_path, checks) for _, file_path, checks in planned]
@@ -0,0 +1,82 @@
+#include "CompileTimeOracle.h"
+#include <chrono>
+#include <llvm/IR/PassInstrumentation.h>
+#include <llvm/Passes/StandardInstrumentations.h>
+
+using namespace llvm;
+
+static double now() {
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Pass managers and adaptors only run other passes.
+static bool isContainer(StringRef PassID) {
+  return isSpecialPass(PassID, {"PassManager", "PassAdaptor",
+                                "AnalysisManagerProxy", "DevirtSCCRepeatedPass",
+                                "ModuleInlinerWrapperPass"});
+}
+
+void PassTimings::registerCallbacks(PassInstrumentationCallbacks &PIC) {
+  PIC.registerBeforeNonSkippedPassCallback([this](StringRef PassID, Any) {
+    if (!isContainer(PassID))
+      Starts.push_back(now());
+  });
+
+  auto After = [this](StringRef PassID) {
+    if (isContainer(PassID) || Starts.empty())
+      return;
+    double Elapsed = now() - Starts.back();
+    Starts.pop_back();
+    Seconds[PassID] += Elapsed;
+    // Passes run inside others are counted once in the total.
+    if (Starts.empty())
+      Total += Elapsed;
+  };
+  PIC.registerAfterPassCallback(
+      [After](StringRef PassID, Any, const PreservedAnalyses &) {
+        After(PassID);
+      });
+  PIC.registerAfterPassInvalidatedCallback(
+      [After](StringRef PassID, const PreservedAnalyses &) { After(PassID); });
+}
+
+void PassTimings::mergeMin(const PassTimings &Other) {
+  for (const auto &Entry : Other.Seconds) {
+    auto [It, Inserted] =
+        Seconds.try_emplace(Entry.getKey(), Entry.getValue());
+    if (!Inserted)
+      It->second = std::min(It->second, Entry.getValue());
+  }
+  Total = std::min(Total, Other.Total);
+}
+
+uint64_t CompileTimeOracle::getSize(const Module &M) {
+  uint64_t Size = 0;
+  for (const Function &F : M)
+    Size += F.getInstructionCount();
+  return Size;
+}
+
+std::optional<CompileTimeOracle::Blowup>
+CompileTimeOracle::check(const PassTimings &Original,
+                         const PassTimings &Mutant) const {
+  // Linear growth with the module is expected.
+  double Growth = std::max<double>(Mutant.Size, 1) /
+                  std::max<double>(Original.Size, 1);
+
+  std::optional<Blowup> Worst;
+  for (const auto &Entry : Mutant.Seconds) {
+    StringRef Pass = Entry.getKey();
+    double MutantSeconds = Entry.getValue();
+    double OriginalSeconds = Original.Seconds.lookup(Pass);
+    if (MutantSeconds - OriginalSeconds < MinSeconds)
+      continue;
+    // Passes too fast to time on the original count as taking a millisecond.
+    double Ratio = MutantSeconds / std::max(OriginalSeconds, 1e-3) / Growth;
+    if (Ratio >= Threshold && (!Worst || Ratio > Worst->Ratio))
+      Worst = Blowup{Pass.str(), OriginalSeconds, MutantSeconds, Ratio};
+  }
+  return Worst;
+}
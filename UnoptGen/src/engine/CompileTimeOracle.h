@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/Module.h>
+#include <optional>
+#include <string>
+
+namespace llvm {
+
+class PassInstrumentationCallbacks;
+
+/*
+ * Time spent in every pass of an optimization pipeline, and the size of the
+ * module it was given.
+ */
+
+struct PassTimings {
+  // Seconds over all runs of a pass, analyses it requested included
+  StringMap<double> Seconds;
+  double Total = 0;
+  // Instructions of the input module
+  uint64_t Size = 0;
+
+  // Register callbacks timing the passes run with PIC into this.
+  void registerCallbacks(PassInstrumentationCallbacks &PIC);
+  // Keep the smaller time of every pass, to filter out noise over repeats of
+  // the same pipeline.
+  void mergeMin(const PassTimings &Other);
+
+private:
+  // Start times of the passes being run, innermost last
+  std::vector<double> Starts;
+};
+
+/*
+ * Flag compile-time blowups: mutants on which a pass is much slower than on
+ * the original, more than the growth of the module explains. These are
+ * performance bugs of the compiler itself.
+ */
+
+class CompileTimeOracle {
+public:
+  struct Blowup {
+    // The pass with the largest slowdown
+    std::string Pass;
+    double OriginalSeconds;
+    double MutantSeconds;
+    // Slowdown per instruction of the input
+    double Ratio;
+  };
+
+  // A pass blows up if its time per instruction grows by Threshold times,
+  // and takes at least MinSeconds more.
+  CompileTimeOracle(double Threshold = 8, double MinSeconds = 0.2)
+      : Threshold(Threshold), MinSeconds(MinSeconds) {}
+
+  std::optional<Blowup> check(const PassTimings &Original,
+                              const PassTimings &Mutant) const;
+
+  static uint64_t getSize(const Module &M);
+
+private:
+  double Threshold;
+  double MinSeconds;
+};
+
+} // namespace llvm
@@ -0,0 +1,211 @@
+#include "CrashGuard.h"
+#include <llvm/ADT/Hashing.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/CrashRecoveryContext.h>
+#include <llvm/Support/ErrorHandling.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Signals.h>
+#include <llvm/Support/raw_ostream.h>
+#include <unistd.h>
+
+using namespace llvm;
+
+// Where the signal handler puts the stack of the crash, if a guard runs
+static std::string *CapturedStack = nullptr;
+
+static void captureStack(void *) {
+  if (!CapturedStack)
+    return;
+  raw_string_ostream OS(*CapturedStack);
+  sys::PrintStackTrace(OS);
+}
+
+// Turn fatal errors into aborts, or they would exit the process.
+static void abortOnFatalError(void *, const char *Reason, bool) {
+  errs() << "LLVM ERROR: " << Reason << "\n";
+  abort();
+}
+
+// Frames of the crash handling itself, the same for every crash
+static const char *IgnoredFrames[] = {
+    "PrintStackTrace",   "SignalHandler",
+    "RunSignalHandlers", "CleanupOnSignal",
+    "CrashRecovery",     "captureStack",
+    "CrashGuard",        "__restore_rt",
+    "raise",             "abort",
+    "__assert",          "__GI_",
+    "pthread_kill",      "report_fatal_error",
+    "llvm_unreachable",  "abortOnFatalError",
+    "libc.so",           "libpthread.so"};
+
+static bool isIgnoredFrame(StringRef Frame) {
+  return any_of(IgnoredFrames,
+                [&](const char *Ignored) { return Frame.contains(Ignored); });
+}
+
+// Frames without symbols are printed as the binary and an offset.
+static bool isSymbolized(StringRef Frame) { return !Frame.contains("+0x"); }
+
+// Parse a frame of sys::PrintStackTrace, like
+//   #3 0x000055d5c2a1 llvm::Foo::bar(int) /path/Foo.cpp:12:3
+// or, without symbols,
+//   #3 0x000055d5c2a1 (/path/binary+0x1234)
+// The file and line are left out, they move with unrelated edits.
+static std::optional<std::string> parseFrame(StringRef Line) {
+  Line = Line.trim();
+  if (!Line.consume_front("#"))
+    return std::nullopt;
+  Line = Line.drop_while(isDigit).ltrim();
+  if (!Line.consume_front("0x"))
+    return std::nullopt;
+  Line = Line.drop_while(isHexDigit).ltrim();
+  if (Line.empty())
+    return std::nullopt;
+
+  if (Line.consume_front("(")) {
+    Line = Line.take_until([](char C) { return C == ')'; });
+    size_t Slash = Line.rfind('/');
+    return Line.substr(Slash == StringRef::npos ? 0 : Slash + 1).str();
+  }
+  size_t File = Line.rfind(" /");
+  return Line.substr(0, File).rtrim().str();
+}
+
+static std::string findMessage(StringRef Log) {
+  SmallVector<StringRef, 32> Lines;
+  Log.split(Lines, '\n');
+  for (StringRef Line : Lines) {
+    if (size_t Pos = Line.find("Assertion `"); Pos != StringRef::npos)
+      return Line.substr(Pos).str();
+    if (size_t Pos = Line.find("LLVM ERROR: "); Pos != StringRef::npos)
+      return Line.substr(Pos).str();
+    if (Line.contains("UNREACHABLE executed"))
+      return Line.trim().str();
+  }
+  return "";
+}
+
+// Numbers in messages are often sizes or indices of the input at hand.
+static std::string maskNumbers(StringRef Message) {
+  std::string Ret;
+  for (size_t I = 0; I < Message.size(); ++I) {
+    if (!isDigit(Message[I])) {
+      Ret += Message[I];
+      continue;
+    }
+    Ret += '#';
+    while (I + 1 < Message.size() && isAlnum(Message[I + 1]))
+      ++I;
+  }
+  return Ret;
+}
+
+static void summarize(CrashReport &Report, StringRef Stack) {
+  Report.Message = findMessage(Report.Log);
+
+  SmallVector<StringRef, 64> Lines;
+  Stack.split(Lines, '\n');
+  std::vector<std::string> Frames;
+  for (StringRef Line : Lines)
+    if (auto Frame = parseFrame(Line))
+      Frames.push_back(*Frame);
+
+  // The crash starts at the first symbolized frame outside of the crash
+  // handling. Without symbols, only the known handling frames are dropped.
+  auto Begin = find_if(Frames, [](StringRef Frame) {
+    return isSymbolized(Frame) && !isIgnoredFrame(Frame);
+  });
+  if (Begin == Frames.end())
+    Begin = Frames.begin();
+  for (auto It = Begin; It != Frames.end(); ++It)
+    if (!isIgnoredFrame(*It))
+      Report.Frames.push_back(*It);
+
+  hash_code Hash = hash_combine(maskNumbers(Report.Message));
+  // Without a message, the signal tells a segfault from an abort.
+  if (Report.Message.empty())
+    Hash = hash_combine(Hash, Report.RetCode);
+  unsigned NumFrames =
+      std::min<size_t>(Report.Frames.size(), CrashGuard::NumBucketFrames);
+  for (unsigned I = 0; I < NumFrames; ++I)
+    Hash = hash_combine(Hash, Report.Frames[I]);
+  Report.Bucket = Hash;
+}
+
+// Redirect stderr to a temporary file while alive.
+class StderrCapture {
+public:
+  StderrCapture() {
+    if (sys::fs::createTemporaryFile("crashguard", "log", FD, Path))
+      return;
+    errs().flush();
+    SavedFD = dup(STDERR_FILENO);
+    dup2(FD, STDERR_FILENO);
+  }
+
+  ~StderrCapture() {
+    restore();
+    if (FD >= 0) {
+      close(FD);
+      sys::fs::remove(Path);
+    }
+  }
+
+  std::string restore() {
+    if (SavedFD < 0)
+      return "";
+    errs().flush();
+    dup2(SavedFD, STDERR_FILENO);
+    close(SavedFD);
+    SavedFD = -1;
+
+    auto Buffer = MemoryBuffer::getFile(Path, /*IsText=*/true);
+    return Buffer ? (*Buffer)->getBuffer().str() : "";
+  }
+
+private:
+  int FD = -1;
+  int SavedFD = -1;
+  SmallString<128> Path;
+};
+
+std::optional<CrashReport> CrashGuard::run(function_ref<void()> Fn) {
+  // Signal handlers run once, so captureStack is registered again after
+  // every crash. The first registration installs the handlers of LLVM, and
+  // must come before those of CrashRecoveryContext.
+  static bool Registered = false;
+  static bool Enabled = false;
+  if (!Registered) {
+    sys::AddSignalHandler(captureStack, nullptr);
+    Registered = true;
+  }
+  if (!Enabled) {
+    CrashRecoveryContext::Enable();
+    Enabled = true;
+  }
+
+  std::string Stack;
+  StderrCapture Capture;
+  ScopedFatalErrorHandler FatalErrors(abortOnFatalError);
+  CrashRecoveryContext CRC;
+  // Run the signal handlers, including captureStack, on a crash.
+  CRC.DumpStackAndCleanupOnFailure = true;
+  CapturedStack = &Stack;
+  bool Succeeded = CRC.RunSafely(Fn);
+  CapturedStack = nullptr;
+
+  if (Succeeded) {
+    // Pass through what was written, it was not a crash.
+    errs() << Capture.restore();
+    return std::nullopt;
+  }
+
+  Registered = false;
+  CrashReport Report;
+  Report.RetCode = CRC.RetCode;
+  Report.Log = Capture.restore() + "\nStack dump:\n" + Stack;
+  summarize(Report, Stack);
+  return Report;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+/*
+ * Run a piece of the engine, e.g. a mutation or an optimization, so that a
+ * crash in it does not take the process down. A crash is summarized by the
+ * assertion or fatal error message and the top frames of its stack, and the
+ * bucket hashing both groups crashes of the same root cause.
+ *
+ * Everything written to stderr while running is captured, so only one guard
+ * may run at a time in a process. The LLVMContext of a crashed run may be
+ * left inconsistent and should be abandoned.
+ */
+
+struct CrashReport {
+  uint64_t Bucket = 0;
+  // Like "Assertion `...' failed." or "LLVM ERROR: ...", if there is one
+  std::string Message;
+  // Innermost first, without the frames of the crash handling
+  std::vector<std::string> Frames;
+  // Signal that ended the run, plus 128
+  int RetCode = 0;
+  // All that was written to stderr, and the stack trace
+  std::string Log;
+};
+
+class CrashGuard {
+public:
+  // Frames of the stack that make up the bucket
+  static const unsigned NumBucketFrames = 5;
+
+  // Run Fn, and return the report of its crash if it crashed.
+  static std::optional<CrashReport> run(function_ref<void()> Fn);
+};
+
+} // namespace llvm
@@ -0,0 +1,125 @@
+#include "DeltaDebugger.h"
+#include "utils/Debug.h"
+#include <climits>
+
+using namespace llvm;
+
+bool DeltaDebugger::isKept(ArrayRef<Chunk> Kept, unsigned Index) {
+  // Chunks are sorted and disjoint.
+  auto It = std::upper_bound(
+      Kept.begin(), Kept.end(), Index,
+      [](unsigned Index, const Chunk &C) { return Index < C.Begin; });
+  return It != Kept.begin() && std::prev(It)->contains(Index);
+}
+
+// Split every chunk into halves. Return false if all chunks are single items.
+static bool increaseGranularity(std::vector<DeltaDebugger::Chunk> &Chunks) {
+  std::vector<DeltaDebugger::Chunk> Splitted;
+  bool SplittedAny = false;
+
+  for (auto C : Chunks) {
+    if (C.size() == 1) {
+      Splitted.push_back(C);
+      continue;
+    }
+    unsigned Half = C.Begin + C.size() / 2;
+    Splitted.push_back({C.Begin, Half});
+    Splitted.push_back({Half, C.End});
+    SplittedAny = true;
+  }
+
+  Chunks = Splitted;
+  return SplittedAny;
+}
+
+std::optional<unsigned>
+DeltaDebugger::testBatch(ArrayRef<std::vector<Chunk>> Batch) {
+  if (Batch.size() == 1) {
+    if (Test(Batch.front(), [] { return false; }))
+      return 0;
+    return std::nullopt;
+  }
+
+  // Index of the first interesting candidate found so far. The candidates
+  // after it are stale.
+  std::atomic<unsigned> Winner = UINT_MAX;
+
+  for (unsigned I = 0; I < Batch.size(); ++I) {
+    Pool->async([&, I] {
+      auto Cancelled = [&Winner, I] { return Winner.load() < I; };
+      if (Cancelled() || !Test(Batch[I], Cancelled))
+        return;
+
+      unsigned Current = Winner.load();
+      while (I < Current && !Winner.compare_exchange_weak(Current, I))
+        ;
+    });
+  }
+  Pool->wait();
+
+  if (Winner == UINT_MAX)
+    return std::nullopt;
+  return Winner.load();
+}
+
+std::vector<DeltaDebugger::Chunk> DeltaDebugger::run(unsigned NumItems) {
+  std::vector<Chunk> Kept;
+  if (NumItems == 0)
+    return Kept;
+  Kept.push_back({0, NumItems});
+
+  // The whole test case is assumed to be interesting.
+  if (NumItems == 1)
+    return Kept;
+
+  if (Jobs > 1 && !Pool)
+    Pool = std::make_unique<ThreadPool>(hardware_concurrency(Jobs));
+
+  increaseGranularity(Kept);
+  do {
+    MODEBUG(dbgs() << "[DeltaDebugger] " << Kept.size() << " chunks\n");
+    std::vector<Chunk> Candidates = Kept;
+
+    for (unsigned I = 0; I < Candidates.size();) {
+      // Build up to Jobs candidates, each removing one more chunk.
+      std::vector<std::vector<Chunk>> Batch;
+      for (unsigned J = I; J < Candidates.size() && Batch.size() < Jobs; ++J) {
+        std::vector<Chunk> Candidate;
+        for (auto C : Kept)
+          if (C.Begin != Candidates[J].Begin)
+            Candidate.push_back(C);
+        Batch.push_back(Candidate);
+      }
+
+      auto Winner = testBatch(Batch);
+      if (!Winner) {
+        I += Batch.size();
+        continue;
+      }
+
+      Chunk Removed = Candidates[I + *Winner];
+      MODEBUG(dbgs() << "[DeltaDebugger] Removed [" << Removed.Begin << ", "
+                     << Removed.End << ")\n");
+      Kept = Batch[*Winner];
+      I += *Winner + 1;
+    }
+  } while (increaseGranularity(Kept));
+
+  return Kept;
+}
+
+std::optional<bool> VerdictCache::lookup(uint64_t Hash) {
+  std::lock_guard<std::mutex> Guard(Lock);
+  auto It = Verdicts.find(Hash);
+  if (It == Verdicts.end()) {
+    Misses++;
+    return std::nullopt;
+  }
+  Hits++;
+  return It->second;
+}
+
+void VerdictCache::insert(uint64_t Hash, bool Verdict) {
+  std::lock_guard<std::mutex> Guard(Lock);
+  Verdicts[Hash] = Verdict;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Support/ThreadPool.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace llvm {
+
+/*
+ * Delta debugging over the items [0, N) of a test case, in the style of
+ * llvm-reduce: sweep over the chunks still considered interesting, try to
+ * remove each of them, and split all chunks once a sweep is finished.
+ *
+ * Up to Jobs removals are evaluated speculatively at the same time. The first
+ * interesting one in sweep order is committed, so the result is the same as
+ * the serial one, and the candidates after it are cancelled because they were
+ * built on a stale state.
+ */
+
+class DeltaDebugger {
+public:
+  struct Chunk {
+    unsigned Begin;
+    unsigned End;
+
+    bool contains(unsigned Index) const {
+      return Begin <= Index && Index < End;
+    }
+    unsigned size() const { return End - Begin; }
+  };
+
+  // Return true if the test case keeping only the items in Kept is still
+  // interesting. Cancelled() turns true once the verdict is not needed any
+  // more; the test should then give up as soon as possible.
+  typedef std::function<bool(ArrayRef<Chunk> Kept,
+                             const std::function<bool()> &Cancelled)>
+      TestFn;
+
+  DeltaDebugger(TestFn Test, unsigned Jobs) : Test(Test), Jobs(Jobs) {}
+
+  // Reduce the items [0, NumItems) and return the chunks still interesting.
+  std::vector<Chunk> run(unsigned NumItems);
+
+  static bool isKept(ArrayRef<Chunk> Kept, unsigned Index);
+
+private:
+  // Return the index of the first interesting candidate in Batch.
+  std::optional<unsigned> testBatch(ArrayRef<std::vector<Chunk>> Batch);
+
+  TestFn Test;
+  unsigned Jobs;
+  std::unique_ptr<ThreadPool> Pool;
+};
+
+/*
+ * Thread-safe memo of test verdicts, keyed by a structural hash of the
+ * candidate. Delta debugging revisits equivalent states quite often.
+ */
+
+class VerdictCache {
+public:
+  std::optional<bool> lookup(uint64_t Hash);
+  void insert(uint64_t Hash, bool Verdict);
+
+  unsigned getHits() const { return Hits; }
+  unsigned getMisses() const { return Misses; }
+
+private:
+  std::mutex Lock;
+  DenseMap<uint64_t, bool> Verdicts;
+  std::atomic<unsigned> Hits = 0;
+  std::atomic<unsigned> Misses = 0;
+};
+
+} // namespace llvm
@@ -0,0 +1,190 @@
+#include "MutationPasses.h"
+#include "transforms/CFGExpand/CFGExpand.h"
+#include "transforms/CFGRandomSimplify/CFGRandomSimplify.h"
+#include "transforms/ExprExpand/ExprExpandPass.h"
+#include "transforms/InstRandomCombine/InstRandomCombine.h"
+#include "transforms/RandomCVP/RandomCVP.h"
+#include "transforms/RandomDSE/RandomDSE.h"
+#include "transforms/RandomLICM/RandomLICM.h"
+#include "transforms/RandomLoopSink/RandomLoopSink.h"
+#include "transforms/RandomMem2Reg/RandomMem2Reg.h"
+#include "transforms/RandomReg2Mem/RandomReg2Mem.h"
+#include "transforms/RandomScalarizer/RandomScalarizer.h"
+#include "transforms/RandomSink/RandomSink.h"
+#include <functional>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Analysis/LoopAnalysisManager.h>
+#include <llvm/Transforms/InstCombine/InstCombine.h>
+#include <llvm/Transforms/Scalar/LoopPassManager.h>
+#include <llvm/Transforms/Scalar/SCCP.h>
+#include <llvm/Transforms/Scalar/SimplifyCFG.h>
+#include <llvm/Transforms/Utils/LCSSA.h>
+#include <llvm/Transforms/Utils/Mem2Reg.h>
+#include <llvm/Transforms/Vectorize/LoopVectorize.h>
+#include <llvm/Transforms/Vectorize/SLPVectorizer.h>
+
+using namespace llvm;
+
+// Add a pass with its parameters to a FunctionPassManager, or return false if
+// the parameters are invalid.
+typedef std::function<bool(FunctionPassManager &, StringRef)> PassAdder;
+
+template <typename PassT> static PassAdder withoutParams() {
+  return [](FunctionPassManager &FPM, StringRef Params) {
+    if (!Params.empty())
+      return false;
+    FPM.addPass(PassT());
+    return true;
+  };
+}
+
+// Like the parameters of the scalarizer of `opt`:
+// "load-store;variable-insert-extract;min-bits=<n>", each can be negated by
+// a "no-" prefix.
+static bool addRandomScalarizer(FunctionPassManager &FPM, StringRef Params) {
+  RandomScalarizerPass Pass;
+  while (!Params.empty()) {
+    StringRef Param;
+    std::tie(Param, Params) = Params.split(';');
+    bool Enable = !Param.consume_front("no-");
+    unsigned Bits;
+    if (Param == "load-store")
+      Pass.setScalarizeLoadStore(Enable);
+    else if (Param == "variable-insert-extract")
+      Pass.setScalarizeVariableInsertExtract(Enable);
+    else if (Enable && Param.consume_front("min-bits=") &&
+             !Param.getAsInteger(0, Bits))
+      Pass.setScalarizeMinBits(Bits);
+    else
+      return false;
+  }
+  FPM.addPass(std::move(Pass));
+  return true;
+}
+
+static bool addRandomLICM(FunctionPassManager &FPM, StringRef Params) {
+  if (!Params.empty())
+    return false;
+  // LICM requires LCSSA guard
+  FPM.addPass(LCSSAPass());
+  FPM.addPass(createFunctionToLoopPassAdaptor(RandomLICMPass(), true));
+  return true;
+}
+
+static const StringMap<PassAdder> &getRegistry() {
+  static const StringMap<PassAdder> Registry = {
+      {"random-inst-expand", withoutParams<ExprExpandPass>()},
+      {"random-inst-combine", withoutParams<InstRandomCombinePass>()},
+      {"random-cfg-simplify", withoutParams<CFGRandomSimplifyPass>()},
+      {"random-cfg-expand", withoutParams<CFGExpandPass>()},
+      {"random-mem2reg", withoutParams<RandomMemToRegPass>()},
+      {"random-reg2mem", withoutParams<RandomRegToMemPass>()},
+      {"random-loopsink", withoutParams<RandomLoopSinkPass>()},
+      {"random-sink", withoutParams<RandomSinkPass>()},
+      {"random-licm", addRandomLICM},
+      {"random-scalarizer", addRandomScalarizer},
+      {"random-cvp", withoutParams<RandomCVPPass>()},
+      {"random-dse", withoutParams<RandomDSEPass>()},
+      // TODO: randomize slp vectorizer
+      {"slp-vectorizer", withoutParams<SLPVectorizerPass>()},
+      {"loop-vectorizer", withoutParams<LoopVectorizePass>()},
+      {"sccp", withoutParams<SCCPPass>()},
+      {"mem2reg", withoutParams<PromotePass>()},
+      {"simplify-cfg", withoutParams<SimplifyCFGPass>()},
+      {"instcombine", withoutParams<InstCombinePass>()},
+  };
+  return Registry;
+}
+
+// Split "<name><<params>>" into the name and the parameters.
+static std::pair<StringRef, StringRef> splitSpec(StringRef Spec) {
+  Spec = Spec.trim();
+  size_t Open = Spec.find('<');
+  if (Open == StringRef::npos || !Spec.ends_with(">"))
+    return {Spec, ""};
+  return {Spec.take_front(Open), Spec.slice(Open + 1, Spec.size() - 1)};
+}
+
+bool llvm::addMutationPass(FunctionPassManager &FPM, StringRef Spec) {
+  auto [Name, Params] = splitSpec(Spec);
+  auto It = getRegistry().find(Name);
+  return It != getRegistry().end() && It->second(FPM, Params);
+}
+
+bool llvm::isMutationPass(StringRef Spec) {
+  FunctionPassManager FPM;
+  return addMutationPass(FPM, Spec);
+}
+
+std::vector<std::string> llvm::getMutationPassNames() {
+  std::vector<std::string> Names;
+  for (const auto &Entry : getRegistry())
+    Names.push_back(Entry.getKey().str());
+  llvm::sort(Names);
+  return Names;
+}
+
+std::vector<std::pair<std::string, int>>
+llvm::getMutationTable(MutationTable T) {
+  switch (T) {
+  case MutationTable::Randomized:
+    return {
+        {"random-inst-expand", 50},
+        {"random-inst-combine", 50},
+        {"random-cfg-simplify", 50},
+        {"random-cfg-expand", 50},
+        {"random-mem2reg", 50},
+        {"random-reg2mem", 50},
+        {"random-loopsink", 50},
+        {"slp-vectorizer", 50},
+        {"loop-vectorizer", 50},
+        {"sccp", 50},
+        {"random-licm", 50},
+        {"random-scalarizer", 50},
+        {"random-cvp", 50},
+        {"random-dse", 50},
+    };
+  case MutationTable::Deoptimize:
+    return {
+        {"random-inst-expand", 50},
+        {"random-cfg-expand", 50},
+        {"random-sink", 50},
+        {"random-reg2mem", 50},
+        {"random-loopsink", 50},
+        {"random-scalarizer", 50},
+    };
+  case MutationTable::Deterministic:
+    return {
+        {"mem2reg", 50},
+        {"slp-vectorizer", 50},
+        {"simplify-cfg", 50},
+        {"loop-vectorizer", 50},
+        {"sccp", 50},
+        {"instcombine", 50},
+    };
+  }
+  return {};
+}
+
+std::vector<std::string> llvm::parseMutationPipeline(StringRef Pipeline) {
+  std::vector<std::string> Passes;
+  // Commas inside the parameters do not separate passes.
+  unsigned Depth = 0;
+  size_t Start = 0;
+  for (size_t I = 0; I <= Pipeline.size(); ++I) {
+    if (I < Pipeline.size()) {
+      if (Pipeline[I] == '<')
+        ++Depth;
+      else if (Pipeline[I] == '>' && Depth)
+        --Depth;
+      if (Pipeline[I] != ',' || Depth)
+        continue;
+    }
+    StringRef Pass = Pipeline.slice(Start, I).trim();
+    if (!Pass.empty())
+      Passes.push_back(Pass.str());
+    Start = I + 1;
+  }
+  return Passes;
+}
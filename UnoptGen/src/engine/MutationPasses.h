@@ -0,0 +1,42 @@
+#pragma once
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/IR/PassManager.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+
+/*
+ * Registry of the passes the pipelines of Mutator and Phaser are made of,
+ * keyed by name. A pass is written "<name>" or "<name><<params>>", with the
+ * parameters separated by ';' like in `opt -passes`, e.g.
+ * "random-scalarizer<min-bits=16;load-store>". A pipeline is a
+ * comma-separated list of passes.
+ */
+
+enum class MutationTable {
+  // Passes that mutate the IR randomly either way
+  Randomized,
+  // Passes that make the IR worse to optimize
+  Deoptimize,
+  // Plain optimization passes
+  Deterministic,
+};
+
+// Add the pass Spec to FPM. Return false if its name or parameters are
+// unknown.
+bool addMutationPass(FunctionPassManager &FPM, StringRef Spec);
+bool isMutationPass(StringRef Spec);
+
+// Names of all the passes, without parameters
+std::vector<std::string> getMutationPassNames();
+
+// Names and weights of the passes of a table
+std::vector<std::pair<std::string, int>> getMutationTable(MutationTable T);
+
+// Split a comma-separated pipeline into passes.
+std::vector<std::string> parseMutationPipeline(StringRef Pipeline);
+
+} // namespace llvm
@@ -0,0 +1,191 @@
+#include "Mutator.h"
+#include "MutationPasses.h"
+#include "trace/Tracer.h"
+#include "utils/Debug.h"
+#include "utils/Files.h"
+#include "utils/Random.h"
+#include <cassert>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Analysis/CGSCCPassManager.h>
+#include <llvm/Analysis/TargetTransformInfo.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/IR/PatternMatch.h>
+#include <llvm/IRPrinter/IRPrintingPasses.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Pass.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/xxhash.h>
+#include <random>
+#include <string>
+
+using namespace llvm;
+
+static cl::opt<int> PrintBefore("print-before-mo", cl::desc("<print-before>"),
+                                cl::init(-1));
+
+// 0: comlete random
+// 1: deoptimize
+// 2: deterministic
+static cl::opt<int> PipelineType("pipeline-type", cl::desc("<pipeline-type>"),
+                                 cl::init(0));
+
+static cl::opt<int> NumLastRemoved("remove-last",
+                                   cl::desc("<remove-last-n-passes>"),
+                                   cl::init(0));
+
+// Tell the tracer which pass of the pipeline makes the following decisions.
+struct TracePassIndexPass : PassInfoMixin<TracePassIndexPass> {
+  TracePassIndexPass(unsigned Index) : Index(Index) {}
+
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &FAM) {
+    Tracer::get()->setPassIndex(Index);
+    return PreservedAnalyses::all();
+  }
+
+  static bool isRequired() { return true; }
+
+  unsigned Index;
+};
+
+// Install the seed of the next pass of the pipeline. Every function draws
+// from its own stream, so that the decisions in a function do not depend on
+// the functions before it.
+struct InstallSeedPass : PassInfoMixin<InstallSeedPass> {
+  InstallSeedPass(ulong Seed) : Seed(Seed) {}
+
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &FAM) {
+    InstallSeed(Seed ^ xxHash64(F.getName()));
+    return PreservedAnalyses::all();
+  }
+
+  static bool isRequired() { return true; }
+
+  ulong Seed;
+};
+
+void Mutator::generateOrReadPipeline() {
+  std::vector<std::string> Ret;
+  if (!PipelineFile.empty()) {
+    // Read from file.
+    Ret = ReadPipeline(PipelineFile);
+  }
+
+  bool NeedToUpdate;
+  if (Ret.empty()) {
+    // Generate pipeline randomly.
+
+    // Between 1 and MaxPasses.
+
+    std::random_device RD;
+    std::mt19937 Gen(RD());
+
+    uint PassesNum = std::uniform_int_distribution<>(0, MaxPassesNum)(Gen);
+
+    std::vector<std::pair<std::string, int>> Passes = getPasses();
+    std::vector<int> Weights;
+    for (auto &[_, Weight] : Passes)
+      Weights.push_back(Weight);
+
+    // Random Distribution of passes.
+    std::discrete_distribution<> d(Weights.begin(), Weights.end());
+
+    for (int i = 0; i < PassesNum; ++i) {
+      Ret.push_back(Passes[d(Gen)].first);
+    }
+  }
+
+  // Update old version of pipeline: indices into the randomized table, and
+  // the reg2mem of the deoptimizing table that used to be named mem2reg.
+  if (!Ret.empty() && isDigit(Ret.front()[0])) {
+    auto Randomized = getMutationTable(MutationTable::Randomized);
+    for (auto &Name : Ret)
+      Name = Randomized[std::stoi(Name)].first;
+    WritePipeline(PipelineFile, Ret);
+  } else if (PipelineType == 1 && is_contained(Ret, "random-mem2reg")) {
+    for (auto &Name : Ret)
+      if (Name == "random-mem2reg")
+        Name = "random-reg2mem";
+    WritePipeline(PipelineFile, Ret);
+  }
+
+  Pipeline = Ret;
+
+  for (auto Name : Ret)
+    MODEBUG(errs() << Name << " ");
+  MODEBUG(errs() << "\n");
+}
+
+void Mutator::storeConfig() {
+  if (!PipelineFile.empty())
+    WritePipeline(PipelineFile, Pipeline);
+}
+
+std::vector<std::pair<std::string, int>> Mutator::getPasses() {
+  switch (PipelineType) {
+  default:
+  case 0:
+    return getMutationTable(MutationTable::Randomized);
+  case 1:
+    return getMutationTable(MutationTable::Deoptimize);
+  case 2:
+    return getMutationTable(MutationTable::Deterministic);
+  }
+}
+
+int Mutator::mutate(Module &M) {
+  assert(!Pipeline.empty() && "");
+
+  LoopAnalysisManager LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager CGAM;
+  ModuleAnalysisManager MAM;
+
+  PassBuilder PB;
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  FunctionPassManager FPM;
+  ModulePassManager MPM;
+
+  int SequenceLen = Pipeline.size() - NumLastRemoved;
+  if (SequenceLen <= 0)
+    return 0;
+
+  // The trace is written at exit.
+  if (!TraceDir.empty()) {
+    sys::fs::create_directories(TraceDir);
+    SmallString<128> TracePath(TraceDir);
+    sys::path::append(TracePath, "trace");
+    Tracer::get()->startRecording(std::string(TracePath));
+  }
+
+  for (int i = 0; i < SequenceLen; i++) {
+    auto CurName = Pipeline[i];
+
+    if (PrintBefore == i)
+      FPM.addPass(PrintFunctionPass());
+
+    if (Tracer::get()->isOn())
+      FPM.addPass(TracePassIndexPass(i));
+
+    if (i < (int)Seeds.size())
+      FPM.addPass(InstallSeedPass(Seeds[i]));
+
+    if (!addMutationPass(FPM, CurName)) {
+      errs() << "Unknown mutation pass " << CurName << "\n";
+      return -1;
+    }
+  }
+
+  MPM.addPass(createModuleToFunctionPassAdaptor(std::move(FPM)));
+  MPM.run(M, MAM);
+  return 0;
+}
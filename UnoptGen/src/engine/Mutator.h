@@ -23,11 +23,27 @@ public:
 
   void generateOrReadPipeline();
 
+  // Use a pipeline that was read elsewhere, e.g. once per reduction instead of
+  // once per oracle call.
+  void setPipeline(const std::vector<std::string> &NewPipeline) {
+    Pipeline = NewPipeline;
+  }
+  const std::vector<std::string> &getPipeline() const { return Pipeline; }
+
+  // Seed every pass of the pipeline on its own, instead of all of them with
+  // the seed installed before mutate().
+  void setSeeds(const std::vector<ulong> &NewSeeds) { Seeds = NewSeeds; }
+
+  // Names and weights of the passes a pipeline can choose from, for the
+  // -pipeline-type in use
+  static std::vector<std::pair<std::string, int>> getPasses();
+
 private:
   int MaxPassesNum;
   std::string PipelineFile;
   std::string TraceDir;
   std::vector<std::string> Pipeline;
+  std::vector<ulong> Seeds;
 };
 
 } // namespace llvm
@@ -0,0 +1,82 @@
+#include "Optimizer.h"
+#include "CompileTimeOracle.h"
+#include "PassTrace.h"
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Analysis/CGSCCPassManager.h>
+#include <llvm/Analysis/LazyCallGraph.h>
+#include <llvm/Analysis/LoopAnalysisManager.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/IR/PassInstrumentation.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+
+// Translate the option passed to `opt` into a textual pass pipeline.
+static std::string toPassPipeline(StringRef Option) {
+  Option = Option.trim();
+  if (Option.consume_front("-passes=") || Option.consume_front("--passes="))
+    return Option.str();
+
+  if (Option.consume_front("-O"))
+    return ("default<O" + Option + ">").str();
+
+  return Option.str();
+}
+
+// Name of the unit of IR a pass runs on.
+static std::string getIRName(const Any &IR) {
+  if (any_cast<const Module *>(&IR))
+    return "module";
+  if (const auto *F = any_cast<const Function *>(&IR))
+    return (*F)->getName().str();
+  if (const auto *C = any_cast<const LazyCallGraph::SCC *>(&IR))
+    return (*C)->getName();
+  if (const auto *L = any_cast<const Loop *>(&IR))
+    return (*L)->getName().str();
+  return "unknown";
+}
+
+Optimizer::Optimizer(const std::string &Pipeline)
+    : PassPipeline(toPassPipeline(Pipeline)) {}
+
+int Optimizer::run(Module &M, PassTimings *Timings, PassTrace *Trace) {
+  LoopAnalysisManager LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager CGAM;
+  ModuleAnalysisManager MAM;
+
+  PassInstrumentationCallbacks PIC;
+  Passes.clear();
+  PIC.registerShouldRunOptionalPassCallback([this](StringRef PassID, Any IR) {
+    Passes.push_back((PassID + " on " + getIRName(IR)).str());
+    return !PassLimit || Passes.size() <= *PassLimit;
+  });
+  if (Timings) {
+    Timings->Size = CompileTimeOracle::getSize(M);
+    Timings->registerCallbacks(PIC);
+  }
+  if (Trace) {
+    Trace->snapshot("input", 0, M.getFunction(Trace->FuncName));
+    Trace->registerCallbacks(PIC, Passes);
+  }
+
+  PassBuilder PB(nullptr, PipelineTuningOptions(), std::nullopt, &PIC);
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  ModulePassManager MPM;
+  if (Error Err = PB.parsePassPipeline(MPM, PassPipeline)) {
+    errs() << "Invalid pipeline " << PassPipeline << ": "
+           << toString(std::move(Err)) << "\n";
+    return -1;
+  }
+
+  Changed = !MPM.run(M, MAM).areAllPreserved();
+  return 0;
+}
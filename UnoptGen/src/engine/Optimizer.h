@@ -0,0 +1,48 @@
+#pragma once
+
+#include <llvm/IR/Module.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+struct PassTimings;
+struct PassTrace;
+
+/*
+ * Run an optimization pipeline in-process, the way `opt` would do it for the
+ * same command line option.
+ */
+
+class Optimizer {
+public:
+  // Pipeline is either an `opt` level like "-O3", a "-passes=<pipeline>"
+  // option or a textual pass pipeline like "default<O3>".
+  Optimizer(const std::string &Pipeline);
+
+  // Optimize M. Return 0 if succeeding, otherwise return -1. If Timings is
+  // given, time every pass into it; if Trace is, snapshot its function after
+  // every pass into it.
+  int run(Module &M, PassTimings *Timings = nullptr,
+          PassTrace *Trace = nullptr);
+
+  const std::string &getPassPipeline() const { return PassPipeline; }
+
+  // Run only the first Limit optional passes, like -opt-bisect-limit.
+  void setPassLimit(std::optional<unsigned> Limit) { PassLimit = Limit; }
+  // Optional passes of the last run, as "<pass> on <unit>", the skipped ones
+  // included.
+  const std::vector<std::string> &getPasses() const { return Passes; }
+  // Whether the last run may have changed M: false only if every pass
+  // preserved all analyses.
+  bool hasChanged() const { return Changed; }
+
+private:
+  std::string PassPipeline;
+  std::optional<unsigned> PassLimit;
+  std::vector<std::string> Passes;
+  bool Changed = true;
+};
+
+} // namespace llvm
@@ -0,0 +1,115 @@
+#include "PassTrace.h"
+#include "transforms/IRNormalizer/IRNormalizer.h"
+#include "utils/Hash.h"
+#include <llvm/Analysis/LazyCallGraph.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassInstrumentation.h>
+#include <llvm/Passes/StandardInstrumentations.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+using namespace llvm;
+
+// The function named Name in the unit of IR a pass ran on, if it is there.
+static Function *findFunction(const Any &IR, StringRef Name) {
+  if (const auto *M = any_cast<const Module *>(&IR))
+    return (*M)->getFunction(Name);
+  if (const auto *F = any_cast<const Function *>(&IR))
+    return (*F)->getName() == Name ? const_cast<Function *>(*F) : nullptr;
+  if (const auto *C = any_cast<const LazyCallGraph::SCC *>(&IR)) {
+    for (LazyCallGraph::Node &N : **C)
+      if (N.getFunction().getName() == Name)
+        return &N.getFunction();
+    return nullptr;
+  }
+  if (const auto *L = any_cast<const Loop *>(&IR)) {
+    Function *F = (*L)->getHeader()->getParent();
+    return F->getName() == Name ? F : nullptr;
+  }
+  return nullptr;
+}
+
+uint64_t PassTrace::getNormalizedHash(Function &F) {
+  // Normalize a copy in a scratch module, where the rest of F's module is
+  // only declared: the module being optimized is never touched, so the pass
+  // managers and their cached analyses never see the copy.
+  ValueToValueMapTy VMap;
+  std::unique_ptr<Module> Scratch =
+      CloneModule(*F.getParent(), VMap,
+                  [&](const GlobalValue *GV) { return GV == &F; });
+  Function &Copy = cast<Function>(*VMap[&F]);
+  FunctionAnalysisManager FAM;
+  IRNormalizerPass().run(Copy, FAM);
+  return hashFunction(Copy);
+}
+
+void PassTrace::snapshot(StringRef Pass, unsigned Index, Function *F) {
+  if (!F || F->isDeclaration())
+    return;
+  PassSnapshot S;
+  S.Pass = Pass.str();
+  S.Index = Index;
+  S.Hash = getNormalizedHash(*F);
+  S.Opcodes.assign(Instruction::OtherOpsEnd, 0);
+  for (BasicBlock &BB : *F)
+    for (Instruction &I : BB)
+      ++S.Opcodes[I.getOpcode()];
+  Snapshots.push_back(std::move(S));
+}
+
+void PassTrace::registerCallbacks(
+    PassInstrumentationCallbacks &PIC,
+    const std::vector<std::string> &OptionalPasses) {
+  PIC.registerAfterPassCallback([this, &OptionalPasses](
+                                    StringRef PassID, Any IR,
+                                    const PreservedAnalyses &PA) {
+    if (isSpecialPass(PassID, {"PassManager", "PassAdaptor",
+                               "AnalysisManagerProxy", "DevirtSCCRepeatedPass",
+                               "ModuleInlinerWrapperPass"}))
+      return;
+    Function *F = findFunction(IR, FuncName);
+    if (!F)
+      return;
+    std::string Pass = (PassID + " on " + F->getName()).str();
+    // An unchanged function needs no rehashing.
+    if (PA.areAllPreserved() && !Snapshots.empty()) {
+      PassSnapshot S = Snapshots.back();
+      S.Pass = Pass;
+      S.Index = OptionalPasses.size();
+      Snapshots.push_back(std::move(S));
+      return;
+    }
+    snapshot(Pass, OptionalPasses.size(), F);
+  });
+}
+
+unsigned Divergence::getDistance(const PassSnapshot &A,
+                                 const PassSnapshot &B) {
+  unsigned Distance = A.Hash != B.Hash;
+  for (unsigned I = 0; I < A.Opcodes.size() && I < B.Opcodes.size(); ++I)
+    Distance += A.Opcodes[I] > B.Opcodes[I] ? A.Opcodes[I] - B.Opcodes[I]
+                                            : B.Opcodes[I] - A.Opcodes[I];
+  return Distance;
+}
+
+Divergence Divergence::compute(const PassTrace &Original,
+                               const PassTrace &Mutant) {
+  Divergence D;
+  const auto &L = Original.Snapshots, &R = Mutant.Snapshots;
+  // Passes named after the function, which is the same on both sides
+  while (D.NumPaired < L.size() && D.NumPaired < R.size() &&
+         L[D.NumPaired].Pass == R[D.NumPaired].Pass)
+    ++D.NumPaired;
+
+  unsigned Best = ~0u;
+  for (unsigned I = 0; I < D.NumPaired; ++I) {
+    if (L[I].Hash == R[I].Hash)
+      D.LastIdentical = I;
+    unsigned Distance = getDistance(L[I], R[I]);
+    if (Distance <= Best) {
+      Best = Distance;
+      D.Closest = I;
+    }
+  }
+  return D;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <llvm/IR/Function.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+class PassInstrumentationCallbacks;
+
+/*
+ * The states of one function along an optimization pipeline: after every
+ * pass run on it, the structural hash of its normalized form and its opcode
+ * histogram. Much smaller than -print-after-all dumps, and enough to tell
+ * where the runs on an original and its mutant part ways.
+ */
+
+struct PassSnapshot {
+  // "<pass> on <unit>", or "input" for the function before the pipeline
+  std::string Pass;
+  // Optional passes run so far, for Optimizer::setPassLimit
+  unsigned Index;
+  uint64_t Hash;
+  // Instructions by opcode
+  std::vector<unsigned> Opcodes;
+};
+
+struct PassTrace {
+  explicit PassTrace(StringRef FuncName) : FuncName(FuncName) {}
+
+  // Function to follow
+  std::string FuncName;
+  std::vector<PassSnapshot> Snapshots;
+
+  // Register callbacks snapshotting the function with PIC. OptionalPasses
+  // are the passes the optimizer was asked to run so far.
+  void registerCallbacks(PassInstrumentationCallbacks &PIC,
+                         const std::vector<std::string> &OptionalPasses);
+  // Record the state of F, if any, after Pass.
+  void snapshot(StringRef Pass, unsigned Index, Function *F);
+
+  // Hash of F in normal form, F itself is left untouched.
+  static uint64_t getNormalizedHash(Function &F);
+};
+
+/*
+ * Where the traces of an original and its mutant part ways. Snapshots are
+ * paired in order as long as the same passes run on both functions.
+ */
+
+struct Divergence {
+  // Last pair of snapshots with identical functions
+  std::optional<unsigned> LastIdentical;
+  // Pair at which the functions are the closest, the last one if several
+  unsigned Closest = 0;
+  // Number of paired snapshots, where the pass sequences stop matching
+  unsigned NumPaired = 0;
+
+  // Opcodes two functions differ by, plus one if they differ otherwise
+  static unsigned getDistance(const PassSnapshot &A, const PassSnapshot &B);
+  static Divergence compute(const PassTrace &Original,
+                            const PassTrace &Mutant);
+};
+
+} // namespace llvm
@@ -0,0 +1,197 @@
+#include "SiteIndex.h"
+#include "transforms/RandomDSE/RandomDSE.h"
+#include "transforms/RandomReg2Mem/RandomReg2Mem.h"
+#include "utils/Files.h"
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/PromoteMemToReg.h>
+
+using namespace llvm;
+
+typedef unsigned (*SiteCounter)(Function &, FunctionAnalysisManager &);
+
+// The binary operators and comparisons ExprExpander expands
+static unsigned countExpandable(Function &F, FunctionAnalysisManager &) {
+  unsigned Sites = 0;
+  for (Instruction &I : instructions(F)) {
+    if (isa<ICmpInst>(I))
+      ++Sites;
+    else if (auto *BinOp = dyn_cast<BinaryOperator>(&I))
+      switch (BinOp->getOpcode()) {
+      case Instruction::Add:
+      case Instruction::Sub:
+      case Instruction::Mul:
+      case Instruction::UDiv:
+      case Instruction::URem:
+      case Instruction::SDiv:
+      case Instruction::SRem:
+      case Instruction::Xor:
+      case Instruction::And:
+      case Instruction::Or:
+      case Instruction::Shl:
+      case Instruction::AShr:
+      case Instruction::LShr:
+        ++Sites;
+        break;
+      default:
+        break;
+      }
+  }
+  return Sites;
+}
+
+// The blocks ending with a branch, which CFGExpander splits
+static unsigned countExpandableBlocks(Function &F, FunctionAnalysisManager &) {
+  unsigned Sites = 0;
+  for (BasicBlock &BB : F)
+    Sites += isa<BranchInst>(BB.getTerminator());
+  return Sites;
+}
+
+static unsigned countPromotable(Function &F, FunctionAnalysisManager &) {
+  unsigned Sites = 0;
+  for (Instruction &I : F.getEntryBlock())
+    if (auto *AI = dyn_cast<AllocaInst>(&I))
+      Sites += isAllocaPromotable(AI);
+  return Sites;
+}
+
+// The instructions of loops whose operands are all invariant in their
+// innermost loop, an upper bound of what LICM hoists
+static unsigned countHoistable(Function &F, FunctionAnalysisManager &AM) {
+  LoopInfo &LI = AM.getResult<LoopAnalysis>(F);
+  unsigned Sites = 0;
+  for (Instruction &I : instructions(F)) {
+    Loop *L = LI.getLoopFor(I.getParent());
+    if (L && !isa<PHINode>(I) && !I.isTerminator() &&
+        L->hasLoopInvariantOperands(&I))
+      ++Sites;
+  }
+  return Sites;
+}
+
+// The instructions producing or taking a vector
+static unsigned countScalarizable(Function &F, FunctionAnalysisManager &) {
+  unsigned Sites = 0;
+  for (Instruction &I : instructions(F))
+    if (I.getType()->isVectorTy() ||
+        any_of(I.operands(),
+               [](Value *Op) { return Op->getType()->isVectorTy(); }))
+      ++Sites;
+  return Sites;
+}
+
+template <typename SitesT>
+static unsigned countSites(Function &F, FunctionAnalysisManager &AM) {
+  SitesT Sites;
+  Sites.enumerate(F, AM);
+  return Sites.getNumSites();
+}
+
+// Counters of the passes, in the order they are run on a function, so that
+// those that change it go last
+static const std::vector<std::pair<StringRef, SiteCounter>> &getCounters() {
+  static const std::vector<std::pair<StringRef, SiteCounter>> Counters = {
+      {"random-inst-expand", countExpandable},
+      {"random-cfg-expand", countExpandableBlocks},
+      {"random-mem2reg", countPromotable},
+      {"random-licm", countHoistable},
+      {"random-scalarizer", countScalarizable},
+      {"random-dse", countSites<RandomDSESites>},
+      {"random-reg2mem", countSites<RandomRegToMemSites>},
+  };
+  return Counters;
+}
+
+bool SiteIndex::isCounted(StringRef Pass) {
+  return any_of(getCounters(),
+                [&](const auto &Counter) { return Counter.first == Pass; });
+}
+
+void SiteIndex::add(StringRef Input, Module &M) {
+  LoopAnalysisManager LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager CGAM;
+  ModuleAnalysisManager MAM;
+
+  PassBuilder PB;
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  FunctionSites &Functions = Inputs[Input.str()];
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    auto &Sites = Functions[F.getName().str()];
+    for (auto &[Pass, Counter] : getCounters())
+      Sites[Pass.str()] = Counter(F, FAM);
+  }
+}
+
+bool SiteIndex::read(const std::string &Path) {
+  std::optional<std::string> Data = ReadFile(Path);
+  if (!Data)
+    return false;
+
+  SmallVector<StringRef> Lines;
+  SplitString(*Data, Lines, "\n");
+  for (StringRef Line : Lines) {
+    SmallVector<StringRef, 4> Fields;
+    Line.split(Fields, '\t');
+    unsigned Sites;
+    if (Fields.size() != 4 || Fields[3].getAsInteger(10, Sites))
+      continue;
+    Inputs[Fields[0].str()][Fields[1].str()][Fields[2].str()] = Sites;
+  }
+  return true;
+}
+
+bool SiteIndex::write(const std::string &Path) const {
+  std::string Data;
+  raw_string_ostream OS(Data);
+  for (auto &[Input, Functions] : Inputs)
+    for (auto &[Function, Sites] : Functions)
+      for (auto &[Pass, Count] : Sites)
+        OS << Input << "\t" << Function << "\t" << Pass << "\t" << Count
+           << "\n";
+  OS.flush();
+  return WriteFile(Path, Data).has_value();
+}
+
+std::optional<unsigned> SiteIndex::getNumSites(StringRef Input,
+                                               StringRef Pass) const {
+  auto It = Inputs.find(Input.str());
+  if (It == Inputs.end() || !isCounted(Pass))
+    return std::nullopt;
+
+  unsigned Sites = 0;
+  for (auto &[_, Counts] : It->second) {
+    auto Count = Counts.find(Pass.str());
+    if (Count != Counts.end())
+      Sites += Count->second;
+  }
+  return Sites;
+}
+
+unsigned SiteIndex::getNumSites(StringRef Input) const {
+  unsigned Sites = 0;
+  for (auto &[Pass, _] : getCounters())
+    Sites += getNumSites(Input, Pass).value_or(0);
+  return Sites;
+}
+
+double SiteIndex::getMeanSites() const {
+  if (Inputs.empty())
+    return 0;
+  double Sites = 0;
+  for (auto &[Input, _] : Inputs)
+    Sites += getNumSites(Input);
+  return Sites / Inputs.size();
+}
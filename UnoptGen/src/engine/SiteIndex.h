@@ -0,0 +1,58 @@
+#pragma once
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/IR/Module.h>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+/*
+ * Index of the mutation sites of a corpus: for every function of every input,
+ * the number of sites each counted pass has there, e.g. the dead stores of
+ * random-dse or the loop-invariant instructions of random-licm. A campaign
+ * gives more mutants to the inputs with more sites.
+ *
+ * The counts are estimates on the original input: a counter may miss some
+ * of what its pass does, e.g. the sinking of LICM, and the passes before it
+ * in a pipeline create new sites. A pass with no site counted may thus still
+ * change an input, and is never ruled out from the count alone.
+ *
+ * The index is stored as lines of "<input>\t<function>\t<pass>\t<count>".
+ * Passes without a counter are not in it.
+ */
+
+class SiteIndex {
+public:
+  // Count the sites of every counted pass on the functions of M, as those of
+  // Input. M may be changed, like the passes would canonicalize it.
+  void add(StringRef Input, Module &M);
+
+  // Read the index at Path, adding its entries. Return false if it can't be
+  // read.
+  bool read(const std::string &Path);
+  bool write(const std::string &Path) const;
+
+  bool contains(StringRef Input) const { return Inputs.count(Input.str()); }
+  unsigned getNumInputs() const { return Inputs.size(); }
+
+  // Sites of Pass on all the functions of Input, or nothing if Pass has no
+  // counter or Input is not indexed
+  std::optional<unsigned> getNumSites(StringRef Input, StringRef Pass) const;
+  // Sites of all the counted passes on Input
+  unsigned getNumSites(StringRef Input) const;
+  // Mean of getNumSites(Input) over the inputs
+  double getMeanSites() const;
+
+  static bool isCounted(StringRef Pass);
+
+private:
+  // Input -> function -> pass -> sites
+  typedef std::map<std::string, std::map<std::string, unsigned>> FunctionSites;
+  std::map<std::string, FunctionSites> Inputs;
+};
+
+} // namespace llvm
@@ -0,0 +1,54 @@
+#include "SiteSampler.h"
+#include "transforms/RandomDSE/RandomDSE.h"
+#include "transforms/RandomReg2Mem/RandomReg2Mem.h"
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+using namespace llvm;
+
+static std::unique_ptr<MutationSites> createSites(StringRef Pass) {
+  if (Pass == "random-dse")
+    return std::make_unique<RandomDSESites>();
+  if (Pass == "random-reg2mem")
+    return std::make_unique<RandomRegToMemSites>();
+  return nullptr;
+}
+
+bool SiteSampler::isSupported(StringRef Pass) {
+  return createSites(Pass) != nullptr;
+}
+
+std::unique_ptr<SiteSampler> SiteSampler::create(const Module &M,
+                                                 StringRef Pass) {
+  std::unique_ptr<MutationSites> Sites = createSites(Pass);
+  if (!Sites)
+    return nullptr;
+
+  std::unique_ptr<Module> Base = CloneModule(M);
+
+  LoopAnalysisManager LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager CGAM;
+  ModuleAnalysisManager MAM;
+
+  PassBuilder PB;
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  for (Function &F : *Base)
+    if (!F.isDeclaration())
+      Sites->enumerate(F, FAM);
+
+  return std::unique_ptr<SiteSampler>(
+      new SiteSampler(std::move(Base), std::move(Sites)));
+}
+
+std::unique_ptr<Module> SiteSampler::sample() const {
+  ValueToValueMapTy VMap;
+  std::unique_ptr<Module> Mutant = CloneModule(*Base, VMap);
+  Sites->apply(Sites->samplePlan(), VMap);
+  return Mutant;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "transforms/MutationSites.h"
+#include <llvm/ADT/StringRef.h>
+#include <llvm/IR/Module.h>
+#include <memory>
+
+namespace llvm {
+
+/*
+ * Draw many mutants of a module from one pass cheaply: the sites of the pass
+ * are enumerated once on a canonical copy of the module, then every mutant is
+ * a clone of the copy with a sampled plan applied, with no analysis rerun.
+ */
+
+class SiteSampler {
+public:
+  // Enumerate the sites of Pass on M. Return nullptr if Pass has no
+  // two-phase form.
+  static std::unique_ptr<SiteSampler> create(const Module &M, StringRef Pass);
+
+  // Whether Pass has a two-phase form
+  static bool isSupported(StringRef Pass);
+
+  unsigned getNumSites() const { return Sites->getNumSites(); }
+
+  // A new mutant, with the sites drawn with the installed seed
+  std::unique_ptr<Module> sample() const;
+
+private:
+  SiteSampler(std::unique_ptr<Module> Base,
+              std::unique_ptr<MutationSites> Sites)
+      : Base(std::move(Base)), Sites(std::move(Sites)) {}
+
+  std::unique_ptr<Module> Base;
+  std::unique_ptr<MutationSites> Sites;
+};
+
+} // namespace llvm
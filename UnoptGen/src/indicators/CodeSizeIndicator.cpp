@@ -0,0 +1,130 @@
+#include "CodeSizeIndicator.h"
+#include <llvm/Analysis/TargetTransformInfo.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Object/SymbolSize.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <mutex>
+#include <utils/Debug.h>
+
+using namespace llvm;
+
+TargetMachine *llvm::getTargetMachine(const Module &M) {
+  static std::mutex Lock;
+  static StringMap<std::unique_ptr<TargetMachine>> Machines;
+
+  std::lock_guard<std::mutex> Guard(Lock);
+  // Only the host target is linked in.
+  static bool Initialized = [] {
+    InitializeNativeTarget();
+    InitializeNativeTargetAsmPrinter();
+    return true;
+  }();
+  (void)Initialized;
+
+  std::string Triple = M.getTargetTriple();
+  if (Triple.empty())
+    Triple = sys::getDefaultTargetTriple();
+
+  auto [It, Inserted] = Machines.try_emplace(Triple);
+  if (!Inserted)
+    return It->second.get();
+
+  std::string Error;
+  const Target *T = TargetRegistry::lookupTarget(Triple, Error);
+  if (!T) {
+    MODEBUG(dbgs() << "No target for " << Triple << ": " << Error << "\n");
+    return nullptr;
+  }
+  It->second.reset(T->createTargetMachine(Triple, "generic", "",
+                                          TargetOptions(), Reloc::PIC_,
+                                          std::nullopt,
+                                          CodeGenOptLevel::Default));
+  return It->second.get();
+}
+
+static int64_t codeSize(Function &F) {
+  PassBuilder PB(getTargetMachine(*F.getParent()));
+  FunctionAnalysisManager FAM;
+  PB.registerFunctionAnalyses(FAM);
+  auto &TTI = FAM.getResult<TargetIRAnalysis>(F);
+
+  int64_t Size = 0;
+  for (Instruction &I : instructions(F))
+    Size += TTI.getInstructionCost(&I, TargetTransformInfo::TCK_CodeSize)
+                .getValue()
+                .value_or(0);
+  return Size;
+}
+
+int64_t CodeSizeIndicator::worth(Function &L, Function &R) {
+  return codeSize(R) - codeSize(L);
+}
+
+// Compile M to an object, and return the size of every function symbol.
+static std::optional<StringMap<uint64_t>> emitSizes(const Module &M) {
+  TargetMachine *TM = getTargetMachine(M);
+  if (!TM)
+    return std::nullopt;
+
+  // Code generation changes the IR, e.g. in CodeGenPrepare.
+  std::unique_ptr<Module> Clone = CloneModule(M);
+  Clone->setDataLayout(TM->createDataLayout());
+
+  SmallString<0> Object;
+  raw_svector_ostream OS(Object);
+  legacy::PassManager PM;
+  if (TM->addPassesToEmitFile(PM, OS, nullptr, CodeGenFileType::ObjectFile))
+    return std::nullopt;
+  PM.run(*Clone);
+
+  auto File = object::ObjectFile::createObjectFile(
+      MemoryBufferRef(StringRef(Object.data(), Object.size()), "size"));
+  if (!File) {
+    consumeError(File.takeError());
+    return std::nullopt;
+  }
+
+  StringMap<uint64_t> Sizes;
+  for (auto &[Symbol, Size] : object::computeSymbolSizes(**File)) {
+    Expected<object::SymbolRef::Type> Type = Symbol.getType();
+    Expected<StringRef> Name = Symbol.getName();
+    if (!Type || !Name) {
+      consumeError(Type.takeError());
+      consumeError(Name.takeError());
+      continue;
+    }
+    if (*Type == object::SymbolRef::ST_Function)
+      Sizes[*Name] += Size;
+  }
+  return Sizes;
+}
+
+std::optional<uint64_t> ObjectSizeIndicator::getSize(Function &F) {
+  auto [It, Inserted] = Sizes.try_emplace(F.getParent());
+  if (Inserted)
+    It->second = emitSizes(*F.getParent());
+  if (!It->second)
+    return std::nullopt;
+
+  // Some object formats prefix symbols with an underscore.
+  for (std::string Name : {F.getName().str(), "_" + F.getName().str()})
+    if (auto Size = It->second->find(Name); Size != It->second->end())
+      return Size->second;
+  // Inlined into all callers and removed
+  return 0;
+}
+
+int64_t ObjectSizeIndicator::worth(Function &L, Function &R) {
+  std::optional<uint64_t> LSize = getSize(L);
+  std::optional<uint64_t> RSize = getSize(R);
+  // Without a backend only the static code size can tell.
+  if (!LSize || !RSize)
+    return CodeSizeIndicator().worth(L, R);
+  return (int64_t)*RSize - (int64_t)*LSize;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "indicators/Indicator.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+#include <optional>
+
+namespace llvm {
+
+// The target machine of M, or of the host if M has no triple. Return nullptr
+// if the target is not built in.
+TargetMachine *getTargetMachine(const Module &M);
+
+/*
+ * Compare the code size of functions by the TCK_CodeSize cost of the target.
+ */
+class CodeSizeIndicator : public Indicator {
+public:
+  int64_t worth(Function &L, Function &R);
+};
+
+/*
+ * Compare the size of the machine code emitted for functions. Every module is
+ * compiled to an object in-process once, and the sizes of all its functions
+ * are read from the symbols.
+ */
+class ObjectSizeIndicator : public Indicator {
+public:
+  int64_t worth(Function &L, Function &R);
+
+private:
+  std::optional<uint64_t> getSize(Function &F);
+
+  DenseMap<const Module *, std::optional<StringMap<uint64_t>>> Sizes;
+};
+} // namespace llvm
@@ -1,4 +1,5 @@
 #include "DiffChecker.h"
+#include <cstdlib>
 #include <llvm/ADT/MapVector.h>
 #include <llvm/ADT/STLExtras.h>
 #include <llvm/IR/InstIterator.h>
@@ -54,3 +55,16 @@ int64_t DiffChecker::worth(Function &L, Function &R) {
 
   return 1;
 }
+
+double DiffChecker::score(Function &L, Function &R) {
+  Opcode2Num LS = NumOp(L);
+  Opcode2Num RS = NumOp(R);
+
+  double Diff = 0;
+  for (auto [Opcode, Num] : LS)
+    Diff += std::abs(int64_t(Num) - int64_t(RS.lookup(Opcode)));
+  for (auto [Opcode, Num] : RS)
+    if (!LS.contains(Opcode))
+      Diff += Num;
+  return Diff;
+}
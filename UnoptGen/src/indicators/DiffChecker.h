@@ -10,5 +10,7 @@ namespace llvm {
 class DiffChecker : public Indicator {
 public:
   int64_t worth(Function &L, Function &R);
+  // Instructions of L and R that differ, by opcode
+  double score(Function &L, Function &R) override;
 };
 } // namespace llvm
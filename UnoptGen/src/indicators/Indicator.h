@@ -7,6 +7,9 @@ class Indicator {
 public:
   // If check(L, R) > 0, it it worthwhile to transform L to R.
   virtual int64_t worth(Function &L, Function &R) = 0;
+  // How much better L is than R, to rank findings by. Indicators whose worth
+  // is only a sign give a magnitude here, e.g. the difference of costs.
+  virtual double score(Function &L, Function &R) { return worth(L, R); }
   virtual ~Indicator() = default;
 };
 } // namespace llvm
@@ -0,0 +1,49 @@
+#include "IndicatorSet.h"
+#include "indicators/CodeSizeIndicator.h"
+#include "indicators/DiffChecker.h"
+#include "indicators/InlineIndicator.h"
+#include "indicators/InstCountIndicator.h"
+#include "indicators/StaticProfileIndicator.h"
+#include "indicators/UBChecker.h"
+#include <llvm/Support/CommandLine.h>
+
+using namespace llvm;
+
+cl::OptionCategory &llvm::getIndicatorCategory() {
+  static cl::OptionCategory Category("Indicator Options");
+  return Category;
+}
+
+static cl::opt<IndicatorMode> Mode(
+    "indicators", cl::desc("What the optimizations are missed for"),
+    cl::init(IndicatorMode::Performance), cl::cat(getIndicatorCategory()),
+    cl::values(clEnumValN(IndicatorMode::Performance, "performance",
+                          "Run time, for -O2/-O3"),
+               clEnumValN(IndicatorMode::CodeSize, "size",
+                          "Code size, for -Os/-Oz")));
+
+std::vector<NamedIndicator> llvm::createIndicators(IndicatorMode Mode) {
+  switch (Mode) {
+  case IndicatorMode::Performance:
+    return {
+        {"inst_count", std::make_shared<InstCountIndicator>()},
+        {"ub", std::make_shared<UBChecker>()},
+        {"inline", std::make_shared<InlineIndicator>()},
+        {"static_profile", std::make_shared<StaticProfileIndicator>()},
+        {"diff", std::make_shared<DiffChecker>()},
+    };
+  case IndicatorMode::CodeSize:
+    return {
+        {"ub", std::make_shared<UBChecker>()},
+        {"inline", std::make_shared<InlineIndicator>()},
+        {"code_size", std::make_shared<CodeSizeIndicator>()},
+        {"object_size", std::make_shared<ObjectSizeIndicator>()},
+        {"diff", std::make_shared<DiffChecker>()},
+    };
+  }
+  llvm_unreachable("Unknown indicator mode");
+}
+
+std::vector<NamedIndicator> llvm::createIndicators() {
+  return createIndicators(Mode);
+}
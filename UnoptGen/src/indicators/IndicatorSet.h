@@ -0,0 +1,33 @@
+#pragma once
+
+#include "indicators/Indicator.h"
+#include <llvm/Support/CommandLine.h>
+#include <memory>
+#include <vector>
+
+namespace llvm {
+
+enum class IndicatorMode {
+  // Hunt missed optimizations of the run time, for -O2/-O3
+  Performance,
+  // Hunt missed optimizations of the code size, for -Os/-Oz
+  CodeSize,
+};
+
+struct NamedIndicator {
+  // Name in score files
+  const char *Name;
+  std::shared_ptr<Indicator> Check;
+};
+
+// A mutant is better optimized than the original if it is better by all the
+// indicators of a mode.
+std::vector<NamedIndicator> createIndicators(IndicatorMode Mode);
+// The indicators of the mode given by -indicators
+std::vector<NamedIndicator> createIndicators();
+
+// Category of -indicators, for the tools that call createIndicators() to list
+// in cl::HideUnrelatedOptions
+cl::OptionCategory &getIndicatorCategory();
+
+} // namespace llvm
@@ -79,6 +79,16 @@ static APInt cost(Function &F, APInt &EntryFreq) {
   return TotalCost;
 }
 
+double StaticProfileIndicator::getCost(Function &F) {
+  APInt EntryFreq(CostBitwidth, 0);
+  APInt Total = cost(F, EntryFreq);
+  return Total.roundToDouble() / std::max(EntryFreq.roundToDouble(), 1.0);
+}
+
+double StaticProfileIndicator::score(Function &L, Function &R) {
+  return getCost(R) - getCost(L);
+}
+
 int64_t StaticProfileIndicator::worth(Function &L, Function &R) {
   APInt LEntryFreq(CostBitwidth, 0);
   APInt REntryFreq(CostBitwidth, 0);
@@ -17,6 +17,10 @@ namespace llvm {
 class StaticProfileIndicator : public Indicator {
 public:
   int64_t worth(Function &L, Function &R);
+  // Expected cycles a call of L saves over R
+  double score(Function &L, Function &R) override;
+  // Expected cost of a call of F
+  static double getCost(Function &F);
 
 protected:
   DenseMap<BasicBlock *, uint64_t> BBCost;
@@ -0,0 +1,58 @@
+#include "transforms/IRNormalizer/IRNormalizer.h"
+#include "utils/Files.h"
+#include "utils/Hash.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/WithColor.h"
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+
+/*
+ * Normalize a module with IRNormalizerPass, so that structurally equivalent
+ * modules are printed identically. Reads stdin and writes stdout by default.
+ */
+
+cl::OptionCategory NormalOptions("Normalizer Options");
+
+static cl::opt<std::string> InputFile(cl::Positional, cl::desc("<input file>"),
+                                      cl::init("-"), cl::cat(NormalOptions));
+static cl::opt<std::string> OutputFile("o", cl::desc("Output file"),
+                                       cl::init("-"), cl::cat(NormalOptions));
+static cl::opt<bool> PrintHash("hash",
+                               cl::desc("Print the structural hash instead"),
+                               cl::cat(NormalOptions));
+
+int main(int Argc, char **Argv) {
+  cl::HideUnrelatedOptions({&NormalOptions, &getColorCategory()});
+  cl::ParseCommandLineOptions(Argc, Argv);
+
+  LLVMContext Context;
+  SMDiagnostic Diag;
+  std::unique_ptr<Module> M = ParseIRFile(InputFile, Diag, Context);
+  if (!M) {
+    Diag.print("llvm-normal", errs());
+    return 1;
+  }
+
+  normalizeModule(*M);
+  // Where the module comes from does not matter either.
+  M->setModuleIdentifier("");
+  M->setSourceFileName("");
+  if (verifyModule(*M, &errs()))
+    return 1;
+
+  if (PrintHash) {
+    outs() << format_hex_no_prefix(hashModule(*M), 16) << "\n";
+    return 0;
+  }
+  if (!WriteModule(*M, OutputFile)) {
+    errs() << "Cannot write " << OutputFile << "\n";
+    return 1;
+  }
+  return 0;
+}
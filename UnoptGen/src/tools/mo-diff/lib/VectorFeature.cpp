@@ -0,0 +1,154 @@
+#include "VectorFeature.h"
+#include <llvm/Analysis/BlockFrequencyInfo.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Analysis/TargetTransformInfo.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <ostream>
+
+using namespace llvm;
+
+// Intrinsics are hashed into buckets, there are too many to give each one a
+// slot.
+static const unsigned NumIntrinsicBuckets = 32;
+
+enum CostClass {
+  TotalCost,
+  MemoryCost,
+  ArithCost,
+  ControlCost,
+  CallCost,
+  IntrinsicCost,
+  VectorCost,
+  NumCostClasses
+};
+
+static const char *CostClassNames[] = {"total",   "memory",    "arith",
+                                       "control", "call",      "intrinsic",
+                                       "vector"};
+
+enum CFGShape {
+  NumBlocks,
+  NumEdges,
+  NumLoops,
+  MaxLoopDepth,
+  NumReturns,
+  NumCondBranches,
+  NumSwitchCases,
+  NumCFGShapes
+};
+
+static const char *CFGShapeNames[] = {"blocks",  "edges",       "loops",
+                                      "depth",   "returns",     "condbrs",
+                                      "switchcases"};
+
+static const unsigned FirstOpcode = Instruction::TermOpsBegin;
+static const unsigned NumOpcodes = Instruction::OtherOpsEnd - FirstOpcode;
+
+static const unsigned CostOffset = NumOpcodes;
+static const unsigned CFGOffset = CostOffset + NumCostClasses;
+static const unsigned IntrinsicOffset = CFGOffset + NumCFGShapes;
+static const unsigned NumFeatures = IntrinsicOffset + NumIntrinsicBuckets;
+
+static CostClass getCostClass(const Instruction &I) {
+  if (isa<IntrinsicInst>(I))
+    return IntrinsicCost;
+  if (isa<CallBase>(I))
+    return CallCost;
+  if (I.mayReadOrWriteMemory() || isa<AllocaInst>(I) ||
+      isa<GetElementPtrInst>(I))
+    return MemoryCost;
+  if (I.isTerminator() || isa<PHINode>(I))
+    return ControlCost;
+  return ArithCost;
+}
+
+// Add the features of F to Features, with the given sign.
+static void addFeatures(Function &F, float Sign,
+                        std::vector<float> &Features) {
+  PassBuilder PB;
+  FunctionAnalysisManager FAM;
+  PB.registerFunctionAnalyses(FAM);
+  auto &TTI = FAM.getResult<TargetIRAnalysis>(F);
+  auto &BFI = FAM.getResult<BlockFrequencyAnalysis>(F);
+  auto &LI = FAM.getResult<LoopAnalysis>(F);
+
+  double EntryFreq = BFI.getEntryFreq().getFrequency();
+  float *Shape = &Features[CFGOffset];
+  for (BasicBlock &BB : F) {
+    // Frequency relative to the entry, so that functions are comparable
+    double Freq = BFI.getBlockFreq(&BB).getFrequency() / EntryFreq;
+
+    for (Instruction &I : BB) {
+      Features[I.getOpcode() - FirstOpcode] += Sign;
+
+      InstructionCost Cost = TTI.getInstructionCost(
+          &I, TargetTransformInfo::TCK_SizeAndLatency);
+      float Weighted = Freq * Cost.getValue().value_or(0);
+      Features[CostOffset + TotalCost] += Sign * Weighted;
+      Features[CostOffset + getCostClass(I)] += Sign * Weighted;
+      if (I.getType()->isVectorTy())
+        Features[CostOffset + VectorCost] += Sign * Weighted;
+
+      if (auto *II = dyn_cast<IntrinsicInst>(&I))
+        Features[IntrinsicOffset +
+                 II->getIntrinsicID() % NumIntrinsicBuckets] += Sign;
+    }
+
+    Instruction *Term = BB.getTerminator();
+    Shape[NumBlocks] += Sign;
+    if (Term) {
+      Shape[NumEdges] += Sign * Term->getNumSuccessors();
+      if (isa<ReturnInst>(Term))
+        Shape[NumReturns] += Sign;
+      if (auto *BI = dyn_cast<BranchInst>(Term))
+        Shape[NumCondBranches] += Sign * BI->isConditional();
+      if (auto *SI = dyn_cast<SwitchInst>(Term))
+        Shape[NumSwitchCases] += Sign * SI->getNumCases();
+    }
+  }
+
+  unsigned Depth = 0;
+  for (Loop *L : LI.getLoopsInPreorder()) {
+    Shape[NumLoops] += Sign;
+    Depth = std::max(Depth, L->getLoopDepth());
+  }
+  Shape[MaxLoopDepth] += Sign * Depth;
+}
+
+std::vector<float> VectorFeature::compute(Function &L, Function &R) {
+  std::vector<float> Features(NumFeatures, 0);
+  addFeatures(L, 1, Features);
+  addFeatures(R, -1, Features);
+  return Features;
+}
+
+const std::vector<std::string> &VectorFeature::getNames() {
+  static const std::vector<std::string> Names = [] {
+    std::vector<std::string> Ret;
+    for (unsigned I = 0; I < NumOpcodes; ++I)
+      Ret.push_back(std::string("op.") +
+                    Instruction::getOpcodeName(FirstOpcode + I));
+    for (const char *Name : CostClassNames)
+      Ret.push_back(std::string("cost.") + Name);
+    for (const char *Name : CFGShapeNames)
+      Ret.push_back(std::string("cfg.") + Name);
+    for (unsigned I = 0; I < NumIntrinsicBuckets; ++I)
+      Ret.push_back("intrinsic." + std::to_string(I));
+    return Ret;
+  }();
+  return Names;
+}
+
+bool VectorFeature::PutDiff(Function &L, Function &R, std::ostream &Out) {
+  std::vector<float> Features = compute(L, R);
+  bool Differs = false;
+  for (unsigned I = 0; I < Features.size(); ++I) {
+    Out << (I ? " " : "") << Features[I];
+    Differs |= Features[I] != 0;
+  }
+  Out << "\n";
+  return Differs;
+}
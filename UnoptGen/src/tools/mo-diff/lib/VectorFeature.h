@@ -0,0 +1,22 @@
+#pragma once
+#include "DiffFeature.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+/*
+ * Dense numeric features of the difference between two functions, for
+ * clustering findings: opcode deltas, block-frequency-weighted cost deltas,
+ * CFG shape deltas and intrinsic usage deltas. Every entry is L - R, and the
+ * layout is the same for every pair.
+ */
+
+class VectorFeature : public DiffFeature {
+public:
+  // Put the vector as a line of space-separated numbers
+  bool PutDiff(Function &L, Function &R, std::ostream &Out);
+
+  static std::vector<float> compute(Function &L, Function &R);
+  static const std::vector<std::string> &getNames();
+};
@@ -1,14 +1,21 @@
 #include "lib/InstFeature.h"
+#include "lib/VectorFeature.h"
 #include "tools/mo-diff/lib/DiffFeature.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/WithColor.h"
+#include "utils/Files.h"
 #include <fstream>
 #include <iostream>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/Threading.h>
+#include <sstream>
 
 using namespace llvm;
 
@@ -17,40 +24,122 @@ cl::OptionCategory MODiffOptions("MODiff Options");
 static cl::opt<std::string> LeftFile(cl::Positional, cl::desc("<first file>"),
                                      cl::Required, cl::cat(MODiffOptions));
 static cl::opt<std::string> RightFile(cl::Positional, cl::desc("<second file>"),
-                                      cl::Required, cl::cat(MODiffOptions));
+                                      cl::cat(MODiffOptions));
 static cl::opt<std::string> DiffFile("o", cl::desc("<diff file to output>"),
                                      cl::cat(MODiffOptions));
 static cl::opt<std::string> FuncName("func", cl::desc("<function name>"),
                                      cl::cat(MODiffOptions));
+static cl::opt<bool>
+    Batch("batch",
+          cl::desc("Put a feature vector for every case under the first "
+                   "argument, a directory"),
+          cl::cat(MODiffOptions));
+static cl::opt<std::string>
+    OriginalName("original-name", cl::desc("Optimized original of a case"),
+                 cl::init("original_opt.ll"), cl::cat(MODiffOptions));
+static cl::opt<std::string>
+    MutantName("mutant-name", cl::desc("Optimized mutant of a case"),
+               cl::init("mutated_opt.ll"), cl::cat(MODiffOptions));
+static cl::opt<unsigned> Jobs("j",
+                              cl::desc("Number of cases to diff concurrently"),
+                              cl::init(0), cl::cat(MODiffOptions));
 
 static std::unique_ptr<Module> readModule(LLVMContext &Context,
                                           StringRef Name) {
   SMDiagnostic Diag;
-  std::unique_ptr<Module> M = parseIRFile(Name, Diag, Context);
+  std::unique_ptr<Module> M = ParseIRFile(Name.str(), Diag, Context);
   if (!M)
     Diag.print("mo-diff", errs());
   return M;
 }
 
 static void writeModule(Module &M, StringRef Name) {
-  // TODO: Support bitcode writer
+  WriteModule(M, Name.str());
+}
+
+// The function a case is about: the one named in its func_name file or by
+// -func, otherwise the first one defined on both sides.
+static std::pair<Function *, Function *>
+findFunctions(StringRef CaseDir, Module &L, Module &R) {
+  SmallString<128> NamePath(CaseDir);
+  sys::path::append(NamePath, "func_name");
+  std::string Name = FuncName;
+  if (auto Data = ReadFile(std::string(NamePath)))
+    Name = StringRef(*Data).trim().str();
+
+  if (!Name.empty())
+    return {L.getFunction(Name), R.getFunction(Name)};
+
+  for (Function &F : L)
+    if (!F.isDeclaration())
+      if (Function *RF = R.getFunction(F.getName());
+          RF && !RF->isDeclaration())
+        return {&F, RF};
+  return {nullptr, nullptr};
+}
+
+// Diff every case under Dir, i.e. every directory holding both optimized
+// modules, and put one line per case: its path and its feature vector.
+static int diffBatch(StringRef Dir, std::ostream &Out) {
+  std::vector<std::string> Cases;
   std::error_code EC;
-  raw_fd_ostream Out(Name, EC, sys::fs::OF_Text);
-  M.print(Out, nullptr);
+  for (sys::fs::recursive_directory_iterator It(Dir, EC), End;
+       It != End && !EC; It.increment(EC)) {
+    if (!sys::fs::is_directory(It->path()))
+      continue;
+    SmallString<128> Original(It->path()), Mutant(It->path());
+    sys::path::append(Original, OriginalName);
+    sys::path::append(Mutant, MutantName);
+    if (sys::fs::exists(Original) && sys::fs::exists(Mutant))
+      Cases.push_back(It->path());
+  }
+  llvm::sort(Cases);
+
+  std::vector<std::string> Lines(Cases.size());
+  {
+    ThreadPool Pool(Jobs ? hardware_concurrency(Jobs)
+                         : hardware_concurrency());
+    for (unsigned I = 0; I < Cases.size(); ++I)
+      Pool.async([&, I] {
+        SmallString<128> Original(Cases[I]), Mutant(Cases[I]);
+        sys::path::append(Original, OriginalName);
+        sys::path::append(Mutant, MutantName);
+
+        // LLVMContext is not thread-safe, every case owns one.
+        LLVMContext Context;
+        auto LModule = readModule(Context, Original);
+        auto RModule = readModule(Context, Mutant);
+        if (!LModule || !RModule)
+          return;
+        auto [L, R] = findFunctions(Cases[I], *LModule, *RModule);
+        if (!L || !R || L->isDeclaration() || R->isDeclaration())
+          return;
+
+        std::ostringstream Line;
+        Line << Cases[I] << " ";
+        VectorFeature().PutDiff(*L, *R, Line);
+        Lines[I] = Line.str();
+      });
+    Pool.wait();
+  }
+
+  Out << "#";
+  for (auto &Name : VectorFeature::getNames())
+    Out << " " << Name;
+  Out << "\n";
+  for (auto &Line : Lines)
+    Out << Line;
+  return 0;
 }
 
 int main(int Argc, char **Argv) {
   cl::HideUnrelatedOptions({&MODiffOptions, &getColorCategory()});
   cl::ParseCommandLineOptions(Argc, Argv);
 
-  LLVMContext Context;
-  InstFeature IF;
-  std::vector<DiffFeature *> Features = {&IF};
-
-  std::unique_ptr<Module> LModule = readModule(Context, LeftFile);
-  std::unique_ptr<Module> RModule = readModule(Context, RightFile);
-  if (!LModule || !RModule)
+  if (!Batch && RightFile.empty()) {
+    errs() << "Two files are required unless -batch is given\n";
     return -1;
+  }
 
   std::ofstream FOut;
   std::ostream *Out;
@@ -63,6 +152,18 @@ int main(int Argc, char **Argv) {
       return -1;
   }
 
+  if (Batch)
+    return diffBatch(LeftFile, *Out);
+
+  LLVMContext Context;
+  InstFeature IF;
+  std::vector<DiffFeature *> Features = {&IF};
+
+  std::unique_ptr<Module> LModule = readModule(Context, LeftFile);
+  std::unique_ptr<Module> RModule = readModule(Context, RightFile);
+  if (!LModule || !RModule)
+    return -1;
+
   Function &L = *LModule->getFunction(FuncName);
   Function &R = *RModule->getFunction(FuncName);
   for (auto *Feature : Features)
@@ -0,0 +1,217 @@
+#include "engine/Optimizer.h"
+#include "indicators/IndicatorSet.h"
+#include "utils/Files.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/WithColor.h"
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+using namespace llvm;
+
+/*
+ * Attribute a missed optimization to a pass. The better optimized side is
+ * optimized again with an opt-bisect limit, and the limit is binary searched
+ * for the first pass after which its function already beats the fully
+ * optimized function of the other side. That pass is the one that fails to
+ * fire on the worse side.
+ *
+ * The search assumes that once the function beats the other side, later
+ * passes keep it so; when they do not, the pass found is still one at which
+ * the indicators flip.
+ */
+
+cl::OptionCategory MOAttributeOptions("MOAttribute Options");
+
+static cl::opt<std::string> OriginalFile(cl::Positional,
+                                         cl::desc("<original file>"),
+                                         cl::Required,
+                                         cl::cat(MOAttributeOptions));
+static cl::opt<std::string> MutantFile(cl::Positional,
+                                       cl::desc("<mutant file>"), cl::Required,
+                                       cl::cat(MOAttributeOptions));
+static cl::opt<std::string>
+    OriginalPipeline("original-opt", cl::desc("Optimization of the original"),
+                     cl::init("-O3"), cl::cat(MOAttributeOptions));
+static cl::opt<std::string>
+    MutantPipeline("mutant-opt", cl::desc("Optimization of the mutant"),
+                   cl::init("-O3"), cl::cat(MOAttributeOptions));
+static cl::opt<std::string>
+    FuncName("func",
+             cl::desc("Function to attribute, the first better one by default"),
+             cl::cat(MOAttributeOptions));
+static cl::opt<bool>
+    ReverseCheck("reverse",
+                 cl::desc("The original is the better optimized side"),
+                 cl::init(false), cl::cat(MOAttributeOptions));
+static cl::opt<std::string>
+    OutputDir("o",
+              cl::desc("Directory to write the modules before and after the "
+                       "pass to"),
+              cl::cat(MOAttributeOptions));
+
+static std::unique_ptr<Module> readModule(LLVMContext &Context,
+                                          StringRef Name) {
+  SMDiagnostic Diag;
+  std::unique_ptr<Module> M = ParseIRFile(Name.str(), Diag, Context);
+  if (!M)
+    Diag.print("moattribute", errs());
+  return M;
+}
+
+static Function *getDefinition(Module &M, StringRef Name) {
+  Function *F = M.getFunction(Name);
+  return F && !F->isDeclaration() ? F : nullptr;
+}
+
+// Whether the function Name of M beats Worse by all the indicators
+static bool isBetter(Module &M, StringRef Name, Function &Worse,
+                     std::vector<NamedIndicator> &Indicators) {
+  Function *F = getDefinition(M, Name);
+  return F && all_of(Indicators, [&](NamedIndicator &I) {
+           return I.Check->worth(*F, Worse) > 0;
+         });
+}
+
+static void printScores(Module &M, StringRef Name, Function &Worse,
+                        std::vector<NamedIndicator> &Indicators) {
+  Function *F = getDefinition(M, Name);
+  if (!F) {
+    outs() << " (function removed)";
+    return;
+  }
+  for (NamedIndicator &I : Indicators)
+    outs() << " " << I.Name << "=" << I.Check->worth(*F, Worse);
+}
+
+static bool writeModule(Module &M, StringRef Name) {
+  SmallString<128> Path(OutputDir.getValue());
+  sys::path::append(Path, Name);
+  if (!WriteModule(M, std::string(Path))) {
+    errs() << "Cannot write " << Path << "\n";
+    return false;
+  }
+  return true;
+}
+
+int main(int Argc, char **Argv) {
+  cl::HideUnrelatedOptions(
+      {&MOAttributeOptions, &getIndicatorCategory(), &getColorCategory()});
+  cl::ParseCommandLineOptions(Argc, Argv);
+
+  LLVMContext Context;
+  std::unique_ptr<Module> Original = readModule(Context, OriginalFile);
+  std::unique_ptr<Module> Mutant = readModule(Context, MutantFile);
+  if (!Original || !Mutant)
+    return 2;
+
+  Module &Better = ReverseCheck ? *Original : *Mutant;
+  Module &Worse = ReverseCheck ? *Mutant : *Original;
+  std::string BetterPipeline = ReverseCheck ? OriginalPipeline : MutantPipeline;
+  std::string WorsePipeline = ReverseCheck ? MutantPipeline : OriginalPipeline;
+
+  std::unique_ptr<Module> WorseOpt = CloneModule(Worse);
+  if (Optimizer(WorsePipeline).run(*WorseOpt))
+    return 2;
+
+  std::vector<NamedIndicator> Indicators = createIndicators();
+
+  // The better side, optimized with its first Limit passes or all of them
+  Optimizer Opt(BetterPipeline);
+  auto Optimize = [&](std::optional<unsigned> Limit) {
+    std::unique_ptr<Module> M = CloneModule(Better);
+    Opt.setPassLimit(Limit);
+    if (Opt.run(*M))
+      M.reset();
+    return M;
+  };
+
+  std::unique_ptr<Module> Full = Optimize(std::nullopt);
+  if (!Full)
+    return 2;
+  unsigned NumPasses = Opt.getPasses().size();
+
+  // Without -func, attribute the first function the better side wins.
+  std::string Name = FuncName;
+  if (Name.empty()) {
+    for (Function &F : *WorseOpt)
+      if (!F.isDeclaration() &&
+          isBetter(*Full, F.getName(), F, Indicators)) {
+        Name = F.getName().str();
+        break;
+      }
+    if (Name.empty()) {
+      errs() << "No function is better optimized\n";
+      return 1;
+    }
+  }
+
+  Function *WorseF = getDefinition(*WorseOpt, Name);
+  if (!WorseF) {
+    errs() << "No function " << Name << " in the optimized "
+           << (ReverseCheck ? "mutant" : "original") << "\n";
+    return 2;
+  }
+  if (!isBetter(*Full, Name, *WorseF, Indicators)) {
+    errs() << Name << " is not better optimized\n";
+    return 1;
+  }
+
+  std::unique_ptr<Module> Unoptimized = Optimize(0);
+  if (!Unoptimized)
+    return 2;
+  if (isBetter(*Unoptimized, Name, *WorseF, Indicators)) {
+    outs() << Name << " is better before any pass\n";
+    return 1;
+  }
+
+  // Better after Hi passes, not after Lo
+  unsigned Lo = 0, Hi = NumPasses;
+  while (Hi - Lo > 1) {
+    unsigned Mid = Lo + (Hi - Lo) / 2;
+    std::unique_ptr<Module> M = Optimize(Mid);
+    if (!M)
+      return 2;
+    if (isBetter(*M, Name, *WorseF, Indicators))
+      Hi = Mid;
+    else
+      Lo = Mid;
+  }
+
+  std::unique_ptr<Module> Before = Optimize(Hi - 1);
+  std::unique_ptr<Module> After = Optimize(Hi);
+  if (!Before || !After)
+    return 2;
+
+  outs() << "Pass " << Hi << " of " << NumPasses << ": "
+         << Opt.getPasses()[Hi - 1] << "\n";
+  outs() << "Before:";
+  printScores(*Before, Name, *WorseF, Indicators);
+  outs() << "\nAfter:";
+  printScores(*After, Name, *WorseF, Indicators);
+  outs() << "\n\n";
+
+  if (Function *F = getDefinition(*Before, Name))
+    outs() << "; Before the pass\n" << *F << "\n";
+  if (Function *F = getDefinition(*After, Name))
+    outs() << "; After the pass\n" << *F << "\n";
+  outs() << "; Fully optimized " << (ReverseCheck ? "mutant" : "original")
+         << "\n"
+         << *WorseF;
+
+  if (!OutputDir.empty()) {
+    if (sys::fs::create_directories(OutputDir)) {
+      errs() << "Cannot create " << OutputDir << "\n";
+      return 2;
+    }
+    if (!writeModule(*Before, "before.ll") ||
+        !writeModule(*After, "after.ll") ||
+        !writeModule(*WorseOpt, "worse.ll"))
+      return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,176 @@
+#include "utils/BlobStore.h"
+#include "utils/Files.h"
+#include "llvm/Support/WithColor.h"
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/LineIterator.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+
+/*
+ * Move campaign artifacts in and out of the blob store given by -blob-store
+ * or $MO_BLOB_STORE.
+ *
+ *   put <files...>    store the files and print their blob:<name> paths
+ *   get <path> [-o]   print a blob, or write it to -o
+ *   pack <dirs...>    store every file of the case directories and replace
+ *                     each by a reference holding its blob path
+ *   unpack <dirs...>  restore the files the references point to
+ *
+ * Packing keeps the layout of the cases, and the tools read references
+ * through ReadFile and ParseIRFile as the files themselves, so packed cases
+ * stay usable by dedup, clustering and reduction.
+ */
+
+cl::OptionCategory MOBlobOptions("MOBlob Options");
+
+static cl::opt<std::string> Command(cl::Positional,
+                                    cl::desc("<put|get|pack|unpack>"),
+                                    cl::Required, cl::cat(MOBlobOptions));
+static cl::list<std::string> Inputs(cl::Positional, cl::desc("<paths>"),
+                                    cl::cat(MOBlobOptions));
+static cl::opt<std::string> OutputFile("o", cl::desc("Output file of get"),
+                                       cl::cat(MOBlobOptions));
+
+static bool put() {
+  for (const std::string &Input : Inputs) {
+    auto Data = ReadFile(Input);
+    auto Name = Data ? WriteFile("blob:", *Data) : std::nullopt;
+    if (!Name) {
+      errs() << "Cannot store " << Input << "\n";
+      return false;
+    }
+    outs() << *Name << " " << Input << "\n";
+  }
+  return true;
+}
+
+static bool get() {
+  if (Inputs.size() != 1) {
+    errs() << "get takes a single blob\n";
+    return false;
+  }
+  std::string Path = Inputs.front();
+  if (!StringRef(Path).starts_with("blob:"))
+    Path = "blob:" + Path;
+  auto Data = ReadFile(Path);
+  if (!Data) {
+    errs() << "No such blob: " << Inputs.front() << "\n";
+    return false;
+  }
+  if (OutputFile.empty()) {
+    outs() << *Data;
+    return true;
+  }
+  return WriteFile(OutputFile, *Data).has_value();
+}
+
+static std::vector<std::string> getFiles(StringRef Dir) {
+  std::vector<std::string> Files;
+  std::error_code EC;
+  for (sys::fs::recursive_directory_iterator It(Dir, EC), End;
+       It != End && !EC; It.increment(EC))
+    if (It->type() == sys::fs::file_type::regular_file)
+      Files.push_back(It->path());
+  llvm::sort(Files);
+  return Files;
+}
+
+static bool pack(StringRef Dir) {
+  // Files are replaced only once all of them are stored, so that a failure
+  // loses nothing.
+  std::vector<std::pair<std::string, std::string>> References;
+  for (const std::string &File : getFiles(Dir)) {
+    if (ReadBlobReference(File))
+      continue;
+    auto Data = ReadFile(File);
+    auto Name = Data ? WriteFile("blob:", *Data) : std::nullopt;
+    if (!Name) {
+      errs() << "Cannot store " << File << "\n";
+      return false;
+    }
+    References.emplace_back(File, *Name);
+  }
+
+  for (auto &[File, Name] : References)
+    if (!WriteFile(File, Name + "\n")) {
+      errs() << "Cannot write " << File << "\n";
+      return false;
+    }
+  return true;
+}
+
+// Cases packed before references used a MANIFEST of "<blob> <path>" lines.
+static bool unpackManifest(StringRef Dir, StringRef ManifestPath) {
+  auto Buffer = MemoryBuffer::getFile(ManifestPath);
+  if (!Buffer) {
+    errs() << "Cannot read " << ManifestPath << "\n";
+    return false;
+  }
+
+  for (line_iterator It(**Buffer); !It.is_at_end(); ++It) {
+    auto [Blob, Relative] = It->split(' ');
+    SmallString<128> Path(Dir);
+    sys::path::append(Path, Relative);
+    auto Data = ReadFile(Blob.str());
+    if (!Data || sys::fs::create_directories(sys::path::parent_path(Path)) ||
+        !WriteFile(std::string(Path), *Data)) {
+      errs() << "Cannot restore " << Path << "\n";
+      return false;
+    }
+  }
+  return !sys::fs::remove(ManifestPath);
+}
+
+static bool unpack(StringRef Dir) {
+  SmallString<128> ManifestPath(Dir);
+  sys::path::append(ManifestPath, "MANIFEST");
+  if (sys::fs::exists(ManifestPath))
+    return unpackManifest(Dir, ManifestPath);
+
+  for (const std::string &File : getFiles(Dir)) {
+    auto Ref = ReadBlobReference(File);
+    if (!Ref)
+      continue;
+    auto Data = ReadFile(*Ref);
+    if (!Data || !WriteFile(File, *Data)) {
+      errs() << "Cannot restore " << File << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int Argc, char **Argv) {
+  cl::HideUnrelatedOptions({&MOBlobOptions, &getColorCategory()});
+  cl::ParseCommandLineOptions(Argc, Argv);
+
+  if (!BlobStore::getDefault()) {
+    errs() << "No blob store, set -blob-store or $MO_BLOB_STORE\n";
+    return 1;
+  }
+
+  if (Command == "put")
+    return !put();
+  if (Command == "get")
+    return !get();
+
+  bool (*Action)(StringRef);
+  if (Command == "pack")
+    Action = pack;
+  else if (Command == "unpack")
+    Action = unpack;
+  else {
+    errs() << "Unknown command: " << Command << "\n";
+    return 1;
+  }
+
+  bool Success = true;
+  for (const std::string &Input : Inputs)
+    Success &= Action(Input);
+  return !Success;
+}
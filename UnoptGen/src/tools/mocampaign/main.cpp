@@ -0,0 +1,609 @@
+#include "engine/CompileTimeOracle.h"
+#include "engine/CrashGuard.h"
+#include "engine/Mutator.h"
+#include "engine/Optimizer.h"
+#include "engine/SiteIndex.h"
+#include "engine/SiteSampler.h"
+#include "indicators/IndicatorSet.h"
+#include "utils/Files.h"
+#include "utils/Hash.h"
+#include "utils/Random.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/WithColor.h"
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/LineIterator.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+
+using namespace llvm;
+
+/*
+ * Run a campaign in a single process: mutate every input a few times,
+ * optimize the original and the mutants in-process and keep the mutants the
+ * original is missing optimizations against, like run.py does.
+ *
+ * Mutation and optimization run under a CrashGuard. Crashes are grouped into
+ * buckets by their message and stack, and only the smallest reproducer of
+ * every bucket is kept in crashed/<bucket>, so that one bad class of inputs
+ * neither floods the disk nor ends the campaign. With -check-compile-time,
+ * mutants a pass of the optimization blows up on are kept in compile-time.
+ *
+ * With -sample-sites=<pass>, the mutants are drawn from the sites of one pass
+ * enumerated once per input, instead of running a random pipeline per mutant.
+ *
+ * With -site-index=<index> written by moindex, an input gets as many more
+ * mutants than -n as it has more sites than the mean input, up to
+ * MaxBudgetScale times, and at least one.
+ *
+ * Mutants structurally equal to the original or to an earlier mutant are not
+ * optimized again. An input is retired once -retire-after mutants in a row
+ * were all duplicates. The tested hashes and the novelty of every input are
+ * kept in the output directory, so that a resumed campaign goes on with them.
+ */
+
+cl::OptionCategory MOCampaignOptions("MOCampaign Options");
+
+static cl::opt<std::string> InputDir(cl::Positional,
+                                     cl::desc("<dir of inputs>"), cl::Required,
+                                     cl::cat(MOCampaignOptions));
+static cl::opt<std::string> OutputDir("o", cl::desc("Directory of results"),
+                                      cl::Required,
+                                      cl::cat(MOCampaignOptions));
+static cl::opt<unsigned> MutantsPerInput("n",
+                                         cl::desc("Mutants of every input"),
+                                         cl::init(3),
+                                         cl::cat(MOCampaignOptions));
+static cl::opt<int> MaxPasses("m", cl::desc("Max number of passes to run"),
+                              cl::init(16), cl::cat(MOCampaignOptions));
+static cl::opt<std::string>
+    OriginalPipeline("original-opt", cl::desc("Optimization of the originals"),
+                cl::init("-O3"), cl::cat(MOCampaignOptions));
+static cl::opt<std::string>
+    MutantPipeline("mutant-opt", cl::desc("Optimization of the mutants"),
+              cl::init("-O3"), cl::cat(MOCampaignOptions));
+static cl::opt<bool> ReverseCheck("reverse", cl::desc("<check reversely>"),
+                                  cl::cat(MOCampaignOptions));
+static cl::opt<bool>
+    CheckCompileTime("check-compile-time",
+                     cl::desc("Keep the mutants a pass blows up on as well"),
+                     cl::cat(MOCampaignOptions));
+static cl::opt<double>
+    BlowupThreshold("blowup-threshold",
+                    cl::desc("Slowdown per instruction of a blowup"),
+                    cl::init(8), cl::cat(MOCampaignOptions));
+static cl::opt<std::string>
+    SampleSites("sample-sites",
+                cl::desc("Draw the mutants from the sites of this pass, "
+                         "enumerated once per input"),
+                cl::cat(MOCampaignOptions));
+static cl::opt<std::string>
+    SiteIndexPath("site-index",
+                  cl::desc("Index of the mutation sites of the inputs"),
+                  cl::cat(MOCampaignOptions));
+static cl::opt<unsigned>
+    RetireAfter("retire-after",
+                cl::desc("Stop mutating an input after this many duplicate "
+                         "mutants in a row, 0 for never"),
+                cl::init(3), cl::cat(MOCampaignOptions));
+static cl::opt<unsigned> CampaignSeed("seed",
+                                      cl::desc("Seed of the mutation seeds"),
+                                      cl::cat(MOCampaignOptions));
+
+// Most mutants of an input, relative to -n, with -site-index
+static const unsigned MaxBudgetScale = 4;
+
+namespace {
+
+struct Bucket {
+  unsigned Count = 0;
+  // Size of the kept reproducer
+  uint64_t Size = 0;
+};
+
+// An attempt that crashed, to be kept if it is the smallest of its bucket
+struct Crash {
+  std::string Stage;
+  StringRef Input;
+  ulong Seed = 0;
+  std::vector<std::string> Pipeline;
+  // Whether the mutant was drawn from sites instead of by the pipeline, so
+  // that the seed and the pipeline don't replay it
+  bool Sampled = false;
+  // Textual IR of a sampled mutant, if the crash came after it was drawn
+  std::string Mutant;
+  CrashReport Report;
+};
+
+// Mutants of an input so far, in this and the resumed campaigns
+struct Novelty {
+  unsigned Mutants = 0;
+  // Mutants no earlier mutant or original was structurally equal to
+  unsigned NewMutants = 0;
+  // Duplicates since the last new mutant
+  unsigned Stale = 0;
+  bool Retired = false;
+};
+
+class Campaign {
+public:
+  bool loadIndex();
+  void loadBuckets();
+  void run(StringRef Input);
+  void printSummary();
+
+private:
+  std::string getPath(StringRef Dir, StringRef Name) const;
+  std::unique_ptr<Module> readModule(LLVMContext &Context, StringRef Name);
+  std::vector<std::string> classify(Module &OriginalOpt, Module &MutatedOpt);
+  unsigned getNumMutants(StringRef Key) const;
+  bool markTested(uint64_t Hash);
+  void saveNovelties() const;
+  void record(const Crash &C);
+  void record(StringRef Input, ulong Seed, ArrayRef<std::string> Pipeline,
+              ArrayRef<Module *> Modules, ArrayRef<std::string> Funcs);
+  void record(StringRef Input, ulong Seed, ArrayRef<std::string> Pipeline,
+              Module &Mutated, const CompileTimeOracle::Blowup &Blowup);
+
+  std::map<uint64_t, Bucket> Buckets;
+  std::optional<SiteIndex> Index;
+  // Structural hashes of the originals and the mutants tested so far, logged
+  // into TestedLog as well
+  DenseSet<uint64_t> Tested;
+  std::unique_ptr<raw_fd_ostream> TestedLog;
+  // By the key of the input
+  std::map<std::string, Novelty> Novelties;
+  unsigned NumFindings = 0;
+  unsigned NumCrashes = 0;
+  unsigned NumBlowups = 0;
+  unsigned NumDuplicates = 0;
+  unsigned NumRetired = 0;
+  unsigned NumSkippedRetired = 0;
+  std::mt19937_64 SeedGen;
+};
+
+} // namespace
+
+std::string Campaign::getPath(StringRef Dir, StringRef Name) const {
+  SmallString<128> Path(OutputDir.getValue());
+  sys::path::append(Path, Dir, Name);
+  return std::string(Path);
+}
+
+// Resume the buckets of a previous campaign in the same directory.
+void Campaign::loadBuckets() {
+  SeedGen.seed(CampaignSeed.getNumOccurrences() ? CampaignSeed
+                                                : std::random_device()());
+
+  std::error_code EC;
+  for (sys::fs::directory_iterator It(getPath("crashed", ""), EC), End;
+       It != End && !EC; It.increment(EC)) {
+    unsigned long long ID;
+    if (getAsUnsignedInteger(sys::path::filename(It->path()), 16, ID))
+      continue;
+    auto Report = MemoryBuffer::getFile(It->path() + "/report");
+    if (!Report)
+      continue;
+    Bucket &B = Buckets[ID];
+    for (line_iterator Line(**Report); !Line.is_at_end(); ++Line) {
+      auto [Key, Value] = Line->split(' ');
+      if (Key == "count")
+        to_integer(Value, B.Count);
+      else if (Key == "size")
+        to_integer(Value, B.Size);
+    }
+  }
+
+  for (sys::fs::directory_iterator It(getPath("missed-opt", ""), EC), End;
+       It != End && !EC; It.increment(EC))
+    ++NumFindings;
+  for (sys::fs::directory_iterator It(getPath("compile-time", ""), EC), End;
+       It != End && !EC; It.increment(EC))
+    ++NumBlowups;
+
+  if (auto Log = MemoryBuffer::getFile(getPath("", "tested")))
+    for (line_iterator Line(**Log); !Line.is_at_end(); ++Line) {
+      uint64_t Hash;
+      if (!Line->getAsInteger(16, Hash))
+        Tested.insert(Hash);
+    }
+  sys::fs::create_directories(OutputDir);
+  TestedLog = std::make_unique<raw_fd_ostream>(getPath("", "tested"), EC,
+                                               sys::fs::OF_Append);
+  if (EC)
+    TestedLog.reset();
+
+  // Lines of "<input>\t<mutants>\t<new mutants>\t<stale>\t<retired>"
+  if (auto Data = ReadFile(getPath("", "novelty"))) {
+    SmallVector<StringRef> Lines;
+    SplitString(*Data, Lines, "\n");
+    for (StringRef Line : Lines) {
+      SmallVector<StringRef, 5> Fields;
+      Line.split(Fields, '\t');
+      Novelty N;
+      if (Fields.size() != 5 || Fields[1].getAsInteger(10, N.Mutants) ||
+          Fields[2].getAsInteger(10, N.NewMutants) ||
+          Fields[3].getAsInteger(10, N.Stale))
+        continue;
+      N.Retired = Fields[4] == "1";
+      Novelties[Fields[0].str()] = N;
+    }
+  }
+}
+
+// Remember Hash as tested, and return whether it is new.
+bool Campaign::markTested(uint64_t Hash) {
+  if (!Tested.insert(Hash).second)
+    return false;
+  if (TestedLog) {
+    *TestedLog << utohexstr(Hash, /*LowerCase=*/true) << "\n";
+    TestedLog->flush();
+  }
+  return true;
+}
+
+void Campaign::saveNovelties() const {
+  std::string Data;
+  raw_string_ostream OS(Data);
+  for (auto &[Key, N] : Novelties)
+    OS << Key << "\t" << N.Mutants << "\t" << N.NewMutants << "\t" << N.Stale
+       << "\t" << N.Retired << "\n";
+  OS.flush();
+  WriteFile(getPath("", "novelty"), Data);
+}
+
+bool Campaign::loadIndex() {
+  if (SiteIndexPath.empty())
+    return true;
+  Index.emplace();
+  return Index->read(SiteIndexPath);
+}
+
+// Mutants of the input indexed as Key
+unsigned Campaign::getNumMutants(StringRef Key) const {
+  if (!MutantsPerInput || !Index || !Index->contains(Key) ||
+      Index->getMeanSites() == 0)
+    return MutantsPerInput;
+  double Scale = Index->getNumSites(Key) / Index->getMeanSites();
+  return std::clamp<unsigned>(std::lround(MutantsPerInput * Scale), 1,
+                              MutantsPerInput * MaxBudgetScale);
+}
+
+std::unique_ptr<Module> Campaign::readModule(LLVMContext &Context,
+                                             StringRef Name) {
+  SMDiagnostic Diag;
+  std::unique_ptr<Module> M = ParseIRFile(Name.str(), Diag, Context);
+  if (!M)
+    Diag.print("mocampaign", errs());
+  return M;
+}
+
+// Functions the mutant is better optimized in, as moclassify decides with
+// the same -indicators.
+std::vector<std::string> Campaign::classify(Module &OriginalOpt,
+                                            Module &MutatedOpt) {
+  std::vector<NamedIndicator> Indicators = createIndicators();
+
+  std::vector<std::string> Funcs;
+  for (Function &L : MutatedOpt) {
+    Function *R = OriginalOpt.getFunction(L.getName());
+    if (L.isDeclaration() || !R || R->isDeclaration())
+      continue;
+    if (all_of(Indicators, [&](NamedIndicator &I) {
+          return ReverseCheck ? I.Check->worth(*R, L) > 0
+                              : I.Check->worth(L, *R) > 0;
+        }))
+      Funcs.push_back(L.getName().str());
+  }
+  return Funcs;
+}
+
+void Campaign::record(const Crash &C) {
+  ++NumCrashes;
+  Bucket &B = Buckets[C.Report.Bucket];
+  ++B.Count;
+
+  uint64_t Size = 0;
+  sys::fs::file_size(C.Input, Size);
+  bool Smaller = B.Count == 1 || Size < B.Size;
+  if (Smaller)
+    B.Size = Size;
+
+  std::string Name = utohexstr(C.Report.Bucket, /*LowerCase=*/true, 16);
+  std::string Dir = getPath("crashed", Name);
+  sys::fs::create_directories(Dir);
+  auto Path = [&](StringRef Name) { return Dir + "/" + Name.str(); };
+
+  if (Smaller) {
+    WithColor::note() << "New reproducer of " << Name << ": "
+                      << C.Report.Message << "\n";
+    if (auto Data = ReadFile(C.Input.str()))
+      WriteFile(Path("original.ll"), *Data);
+    WriteSeed(Path("seed"), C.Seed);
+    WritePipeline(Path("pipeline"), C.Pipeline);
+    WriteFile(Path("log"), C.Report.Log);
+    if (!C.Mutant.empty())
+      WriteFile(Path("mutated.ll"), C.Mutant);
+    else
+      sys::fs::remove(Path("mutated.ll"));
+  }
+
+  std::string Report;
+  raw_string_ostream OS(Report);
+  OS << "count " << B.Count << "\n";
+  OS << "size " << B.Size << "\n";
+  if (Smaller || !sys::fs::exists(Path("report"))) {
+    OS << "stage " << C.Stage << "\n";
+    OS << "source " << C.Input << "\n";
+    // How to get the crashing mutant back: from the seed and the pipeline,
+    // from mutated.ll, or not at all for a crash while drawing it.
+    OS << "replay "
+       << (!C.Mutant.empty() ? "mutant" : C.Sampled ? "none" : "seed")
+       << "\n";
+    OS << "retcode " << C.Report.RetCode << "\n";
+    OS << "message " << C.Report.Message << "\n";
+    for (const std::string &Frame : C.Report.Frames)
+      OS << "frame " << Frame << "\n";
+  } else if (auto Old = MemoryBuffer::getFile(Path("report"))) {
+    // Only the count changes.
+    for (line_iterator Line(**Old); !Line.is_at_end(); ++Line)
+      if (!Line->starts_with("count ") && !Line->starts_with("size "))
+        OS << *Line << "\n";
+  }
+  OS.flush();
+  WriteFile(Path("report"), Report);
+}
+
+void Campaign::record(StringRef Input, ulong Seed,
+                      ArrayRef<std::string> Pipeline,
+                      ArrayRef<Module *> Modules,
+                      ArrayRef<std::string> Funcs) {
+  static const char *ModuleNames[] = {"original.ll", "mutated.ll",
+                                      "original_opt.ll", "mutated_opt.ll"};
+
+  std::string Dir;
+  do
+    Dir = getPath("missed-opt", std::to_string(NumFindings++));
+  while (sys::fs::exists(Dir));
+  sys::fs::create_directories(Dir);
+  auto Path = [&](StringRef Name) { return Dir + "/" + Name.str(); };
+
+  for (unsigned I = 0; I < Modules.size(); ++I)
+    WriteModule(*Modules[I], Path(ModuleNames[I]));
+  WriteSeed(Path("seed"), Seed);
+  WritePipeline(Path("pipeline"), Pipeline);
+  WriteFile(Path("func_names"), join(Funcs, "\n") + "\n");
+  WriteFile(Path("source_path.txt"), Input.str() + "\n");
+}
+
+void Campaign::record(StringRef Input, ulong Seed,
+                      ArrayRef<std::string> Pipeline, Module &Mutated,
+                      const CompileTimeOracle::Blowup &Blowup) {
+  WithColor::note() << "Blowup in " << Blowup.Pass << " on a mutant of "
+                    << Input << "\n";
+
+  std::string Dir;
+  do
+    Dir = getPath("compile-time", std::to_string(NumBlowups++));
+  while (sys::fs::exists(Dir));
+  sys::fs::create_directories(Dir);
+  auto Path = [&](StringRef Name) { return Dir + "/" + Name.str(); };
+
+  if (auto Data = ReadFile(Input.str()))
+    WriteFile(Path("original.ll"), *Data);
+  WriteModule(Mutated, Path("mutated.ll"));
+  WriteSeed(Path("seed"), Seed);
+  WritePipeline(Path("pipeline"), Pipeline);
+
+  std::string Report;
+  raw_string_ostream OS(Report);
+  OS << "pass " << Blowup.Pass << "\n";
+  OS << "original " << format("%.3f", Blowup.OriginalSeconds) << "\n";
+  OS << "mutant " << format("%.3f", Blowup.MutantSeconds) << "\n";
+  OS << "ratio " << format("%.1f", Blowup.Ratio) << "\n";
+  OS << "source " << Input << "\n";
+  OS.flush();
+  WriteFile(Path("report"), Report);
+}
+
+void Campaign::run(StringRef Input) {
+  // The inputs are indexed by their path relative to the corpus.
+  SmallString<128> Name(Input);
+  sys::path::replace_path_prefix(Name, InputDir, "");
+  StringRef Key = sys::path::relative_path(Name);
+  Novelty &N = Novelties[Key.str()];
+  if (N.Retired) {
+    ++NumSkippedRetired;
+    return;
+  }
+
+  // A crashed run may leave its context inconsistent, so the context and its
+  // modules are leaked instead of destroyed then.
+  auto *Context = new LLVMContext;
+  std::unique_ptr<Module> Original, OriginalOpt;
+  std::unique_ptr<SiteSampler> Sampler;
+  PassTimings OriginalTimings;
+  PassTimings *Timings = CheckCompileTime ? &OriginalTimings : nullptr;
+  Crash C;
+  C.Input = Input;
+  auto Abandon = [&] {
+    Original.release();
+    OriginalOpt.release();
+    Sampler.release();
+    record(C);
+    saveNovelties();
+  };
+
+  C.Stage = "optimize-original";
+  std::optional<CrashReport> Report = CrashGuard::run([&] {
+    Original = readModule(*Context, Input);
+    if (!Original)
+      return;
+    OriginalOpt = CloneModule(*Original);
+    Optimizer(OriginalPipeline).run(*OriginalOpt, Timings);
+
+    if (!SampleSites.empty()) {
+      C.Stage = "enumerate";
+      C.Sampled = true;
+      Sampler = SiteSampler::create(*Original, SampleSites);
+    }
+  });
+  if (Report) {
+    C.Report = std::move(*Report);
+    Abandon();
+    return;
+  }
+  if (!Original) {
+    delete Context;
+    return;
+  }
+
+  markTested(hashModule(*Original));
+  unsigned NumMutants = getNumMutants(Key);
+  for (unsigned I = 0; I < NumMutants; ++I) {
+    C.Seed = SeedGen();
+    InstallSeed(C.Seed);
+    Mutator Mutator(MaxPasses, "", "");
+    if (Sampler) {
+      C.Pipeline = {SampleSites};
+    } else {
+      Mutator.generateOrReadPipeline();
+      C.Pipeline = Mutator.getPipeline();
+    }
+    if (C.Pipeline.empty())
+      continue;
+
+    std::unique_ptr<Module> Mutated, MutatedOpt;
+    std::vector<std::string> Funcs;
+    PassTimings MutantTimings;
+    bool Duplicate = false;
+    C.Sampled = Sampler != nullptr;
+    C.Mutant.clear();
+    Report = CrashGuard::run([&] {
+      C.Stage = "mutate";
+      if (Sampler) {
+        Mutated = Sampler->sample();
+      } else {
+        Mutated = CloneModule(*Original);
+        Mutator.mutate(*Mutated);
+      }
+
+      C.Stage = "hash";
+      Duplicate = !markTested(hashModule(*Mutated));
+      if (Duplicate)
+        return;
+
+      // The plan was drawn differently from the pass, keep the mutant itself.
+      if (Sampler) {
+        raw_string_ostream OS(C.Mutant);
+        Mutated->print(OS, nullptr);
+      }
+
+      C.Stage = "optimize-mutant";
+      MutatedOpt = CloneModule(*Mutated);
+      Optimizer(MutantPipeline)
+          .run(*MutatedOpt, Timings ? &MutantTimings : nullptr);
+
+      C.Stage = "classify";
+      Funcs = classify(*OriginalOpt, *MutatedOpt);
+    });
+
+    // The context is gone, so are the other mutants of this input.
+    if (Report) {
+      Mutated.release();
+      MutatedOpt.release();
+      C.Report = std::move(*Report);
+      Abandon();
+      return;
+    }
+
+    ++N.Mutants;
+    if (Duplicate) {
+      ++NumDuplicates;
+      if (RetireAfter && ++N.Stale >= RetireAfter) {
+        N.Retired = true;
+        ++NumRetired;
+        break;
+      }
+      continue;
+    }
+    ++N.NewMutants;
+    N.Stale = 0;
+
+    if (!Funcs.empty())
+      record(Input, C.Seed, C.Pipeline,
+             {Original.get(), Mutated.get(), OriginalOpt.get(),
+              MutatedOpt.get()},
+             Funcs);
+
+    if (Timings)
+      if (auto Blowup = CompileTimeOracle(BlowupThreshold)
+                            .check(OriginalTimings, MutantTimings))
+        record(Input, C.Seed, C.Pipeline, *Mutated, *Blowup);
+  }
+
+  saveNovelties();
+  Sampler.reset();
+  Original.reset();
+  OriginalOpt.reset();
+  delete Context;
+}
+
+void Campaign::printSummary() {
+  outs() << "=======Result=======\n";
+  outs() << "Found " << NumFindings << " candidates\n";
+  outs() << "Found " << NumCrashes << " crashes in " << Buckets.size()
+         << " buckets\n";
+  if (CheckCompileTime)
+    outs() << "Found " << NumBlowups << " compile-time blowups\n";
+  outs() << "Skipped " << NumDuplicates << " duplicate mutants, retired "
+         << NumRetired << " inputs\n";
+  if (NumSkippedRetired)
+    outs() << "Skipped " << NumSkippedRetired << " inputs retired before\n";
+}
+
+int main(int Argc, char **Argv) {
+  cl::HideUnrelatedOptions(
+      {&MOCampaignOptions, &getIndicatorCategory(), &getColorCategory()});
+  cl::ParseCommandLineOptions(Argc, Argv);
+
+  if (!SampleSites.empty() && !SiteSampler::isSupported(SampleSites)) {
+    WithColor::error() << "No sites can be enumerated for " << SampleSites
+                       << "\n";
+    return -1;
+  }
+
+  std::vector<std::string> Inputs;
+  std::error_code EC;
+  for (sys::fs::recursive_directory_iterator It(InputDir, EC), End;
+       It != End && !EC; It.increment(EC))
+    if (sys::path::extension(It->path()) == ".ll")
+      Inputs.push_back(It->path());
+  llvm::sort(Inputs);
+
+  Campaign C;
+  if (!C.loadIndex()) {
+    WithColor::error() << "Cannot read " << SiteIndexPath << "\n";
+    return -1;
+  }
+  C.loadBuckets();
+  for (unsigned I = 0; I < Inputs.size(); ++I) {
+    C.run(Inputs[I]);
+    outs() << "\rProgress: [" << I + 1 << "/" << Inputs.size() << "]";
+    outs().flush();
+  }
+  outs() << "\n";
+  C.printSummary();
+  return 0;
+}
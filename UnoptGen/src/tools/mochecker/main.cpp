@@ -6,6 +6,7 @@
 #include "indicators/UBChecker.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/WithColor.h"
+#include "utils/Files.h"
 #include <iostream>
 #include <llvm/ADT/StringExtras.h>
 #include <llvm/ADT/iterator_range.h>
@@ -49,7 +50,7 @@ static cl::opt<bool> ReverseCheck("reverse", cl::desc("<check reversely>"),
 static std::unique_ptr<Module> readModule(LLVMContext &Context,
                                           StringRef Name) {
   SMDiagnostic Diag;
-  std::unique_ptr<Module> M = parseIRFile(Name, Diag, Context);
+  std::unique_ptr<Module> M = ParseIRFile(Name.str(), Diag, Context);
   if (!M)
     Diag.print("mochecker", errs());
   return M;
@@ -1,5 +1,6 @@
 #include "indicators/DiffChecker.h"
 #include "indicators/Indicator.h"
+#include "indicators/IndicatorSet.h"
 #include "indicators/InlineIndicator.h"
 #include "indicators/InstCountIndicator.h"
 #include "indicators/LoopIndicator.h"
@@ -8,6 +9,7 @@
 #include "llvm/Support/Program.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/WithColor.h"
+#include "utils/Files.h"
 #include <filesystem>
 #include <iostream>
 #include <llvm/ADT/StringExtras.h>
@@ -16,6 +18,9 @@
 #include <llvm/IR/Module.h>
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <optional>
 
 using namespace llvm;
 
@@ -35,11 +40,15 @@ static cl::opt<std::string> OutputDir("output", cl::desc("<Output directory>"),
                                       cl::cat(MOClassifyOptions));
 static cl::opt<bool> ReverseCheck("reverse", cl::desc("<check reversely>"),
                                   cl::cat(MOClassifyOptions), cl::init(false));
+static cl::opt<std::string>
+    ScoreFile("scores",
+              cl::desc("File of the indicator scores of interesting functions"),
+              cl::cat(MOClassifyOptions));
 
 static std::unique_ptr<Module> readModule(LLVMContext &Context,
                                           StringRef Name) {
   SMDiagnostic Diag;
-  std::unique_ptr<Module> M = parseIRFile(Name, Diag, Context);
+  std::unique_ptr<Module> M = ParseIRFile(Name.str(), Diag, Context);
   if (!M)
     Diag.print("moclassify", errs());
   return M;
@@ -50,10 +59,7 @@ template <typename T> static std::string joinStringList(T Set) {
 }
 
 static void writeModule(Module &M, StringRef Name) {
-  // TODO: Support bitcode writer
-  std::error_code EC;
-  raw_fd_ostream Out(Name, EC, sys::fs::OF_Text);
-  M.print(Out, nullptr);
+  WriteModule(M, Name.str());
 }
 
 static void extractFunc(const std::string &ModuleFile,
@@ -66,7 +72,8 @@ static void extractFunc(const std::string &ModuleFile,
 }
 
 int main(int Argc, char **Argv) {
-  cl::HideUnrelatedOptions({&MOClassifyOptions, &getColorCategory()});
+  cl::HideUnrelatedOptions(
+      {&MOClassifyOptions, &getIndicatorCategory(), &getColorCategory()});
   cl::ParseCommandLineOptions(Argc, Argv);
 
   LLVMContext Context;
@@ -76,18 +83,22 @@ int main(int Argc, char **Argv) {
   if (!LModule || !RModule)
     return 1;
 
-  std::vector<std::shared_ptr<Indicator>> Indicators = {
-      std::make_shared<InstCountIndicator>(),
-      std::make_shared<UBChecker>(),
-      std::make_shared<InlineIndicator>(),
-      std::make_shared<StaticProfileIndicator>(),
-      std::make_shared<DiffChecker>(),
-  };
+  std::vector<NamedIndicator> Indicators = createIndicators();
+
+  std::error_code EC;
+  std::optional<raw_fd_ostream> Scores;
+  if (!ScoreFile.empty()) {
+    Scores.emplace(ScoreFile, EC, sys::fs::OF_Text);
+    if (EC) {
+      errs() << "Cannot write " << ScoreFile << "\n";
+      return 1;
+    }
+  }
 
   auto IsBetter = [&](Function &L, Function &R) -> bool {
     return std::all_of(
         Indicators.begin(), Indicators.end(),
-        [&](std::shared_ptr<Indicator> I) { return I->worth(L, R) > 0; });
+        [&](NamedIndicator &I) { return I.Check->worth(L, R) > 0; });
   };
 
   std::filesystem::path OutputDirPath(OutputDir.getValue());
@@ -116,6 +127,14 @@ int main(int Argc, char **Argv) {
     if (Success) {
       outs() << LF.getName() << "\n";
       InterestingNess = true;
+      if (Scores) {
+        *Scores << LF.getName();
+        for (unsigned I = 0; I < Indicators.size(); ++I)
+          *Scores << " " << Indicators[I].Name << "="
+                  << (ReverseCheck ? Indicators[I].Check->score(*RF, LF)
+                                   : Indicators[I].Check->score(LF, *RF));
+        *Scores << "\n";
+      }
       // std::filesystem::path Dir = OutputDirPath / IndexStr;
       // extractFunc(LeftFilename, FuncName, (Dir / "mutated.ll"));
       // extractFunc(RightFilename, FuncName, (Dir / "original.ll"));
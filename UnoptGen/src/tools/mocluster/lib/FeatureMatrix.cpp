@@ -0,0 +1,24 @@
+#include "FeatureMatrix.h"
+#include <cmath>
+
+using namespace llvm;
+
+void FeatureMatrix::standardize() {
+  if (Rows == 0)
+    return;
+
+  for (unsigned C = 0; C < Cols; ++C) {
+    double Sum = 0, SquaredSum = 0;
+    for (unsigned R = 0; R < Rows; ++R) {
+      double V = row(R)[C];
+      Sum += V;
+      SquaredSum += V * V;
+    }
+    double Mean = Sum / Rows;
+    double Variance = std::max(0.0, SquaredSum / Rows - Mean * Mean);
+    double Deviation = std::sqrt(Variance);
+    // Constant columns carry no information.
+    for (unsigned R = 0; R < Rows; ++R)
+      row(R)[C] = Deviation > 0 ? (row(R)[C] - Mean) / Deviation : 0;
+  }
+}
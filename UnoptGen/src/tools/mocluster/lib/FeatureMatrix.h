@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace llvm {
+
+// Eight floats, processed by one SIMD instruction where the target has AVX
+// and by two otherwise.
+typedef float FloatLanes __attribute__((vector_size(32)));
+constexpr unsigned NumLanes = sizeof(FloatLanes) / sizeof(float);
+
+/*
+ * Row-major matrix of feature vectors. Every row is padded with zeros to a
+ * whole number of lanes, so that the distance kernel has no scalar tail.
+ */
+
+class FeatureMatrix {
+public:
+  FeatureMatrix(unsigned Rows, unsigned Cols)
+      : Rows(Rows), Cols(Cols), LanesPerRow((Cols + NumLanes - 1) / NumLanes),
+        Data(Rows * LanesPerRow, FloatLanes{}) {}
+
+  unsigned getRows() const { return Rows; }
+  unsigned getCols() const { return Cols; }
+
+  float *row(unsigned I) {
+    return reinterpret_cast<float *>(&Data[I * LanesPerRow]);
+  }
+  const FloatLanes *lanes(unsigned I) const { return &Data[I * LanesPerRow]; }
+
+  // Squared Euclidean distance between rows I and J
+  float distance(unsigned I, unsigned J) const {
+    const FloatLanes *A = lanes(I), *B = lanes(J);
+    FloatLanes Sum = {};
+    for (unsigned L = 0; L < LanesPerRow; ++L) {
+      FloatLanes D = A[L] - B[L];
+      Sum += D * D;
+    }
+    float Ret = 0;
+    for (unsigned L = 0; L < NumLanes; ++L)
+      Ret += Sum[L];
+    return Ret;
+  }
+
+  // Scale every column to zero mean and unit variance, so that counts and
+  // costs weigh the same.
+  void standardize();
+
+private:
+  unsigned Rows;
+  unsigned Cols;
+  unsigned LanesPerRow;
+  std::vector<FloatLanes> Data;
+};
+
+} // namespace llvm
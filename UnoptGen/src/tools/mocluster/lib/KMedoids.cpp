@@ -0,0 +1,148 @@
+#include "KMedoids.h"
+#include "utils/Debug.h"
+#include <cmath>
+
+using namespace llvm;
+
+// Sizes of the samples of a cluster when moving its medoid
+static const unsigned NumCandidates = 256;
+static const unsigned NumEvaluated = 2048;
+
+void KMedoids::parallelFor(unsigned N, std::function<void(unsigned)> Fn) {
+  // Enough chunks to balance the load on any machine, few enough to keep the
+  // overhead negligible.
+  unsigned NumChunks = std::min(N, 256u);
+  for (unsigned Chunk = 0; Chunk < NumChunks; ++Chunk)
+    Pool.async([&, Chunk] {
+      for (unsigned I = (uint64_t)N * Chunk / NumChunks,
+                    E = (uint64_t)N * (Chunk + 1) / NumChunks;
+           I < E; ++I)
+        Fn(I);
+    });
+  Pool.wait();
+}
+
+void KMedoids::seed() {
+  unsigned N = X.getRows();
+  Medoids.clear();
+  Medoids.push_back(std::uniform_int_distribution<unsigned>(0, N - 1)(Gen));
+  Distances.assign(N, 0);
+  parallelFor(N, [&](unsigned I) {
+    Distances[I] = X.distance(I, Medoids.front());
+  });
+
+  // Pick the next medoid with a probability proportional to its squared
+  // distance to the nearest one so far.
+  while (Medoids.size() < K) {
+    double Total = 0;
+    for (float D : Distances)
+      Total += D;
+    // Fewer distinct rows than clusters
+    if (Total == 0)
+      break;
+
+    double Target = std::uniform_real_distribution<double>(0, Total)(Gen);
+    unsigned Next = 0;
+    for (; Next + 1 < N && Target >= Distances[Next]; ++Next)
+      Target -= Distances[Next];
+    Medoids.push_back(Next);
+
+    parallelFor(N, [&](unsigned I) {
+      Distances[I] = std::min(Distances[I], X.distance(I, Next));
+    });
+  }
+}
+
+double KMedoids::assign() {
+  unsigned N = X.getRows();
+  Assignment.resize(N);
+  Distances.resize(N);
+  parallelFor(N, [&](unsigned I) {
+    unsigned Best = 0;
+    float BestDistance = X.distance(I, Medoids[0]);
+    for (unsigned C = 1; C < Medoids.size(); ++C) {
+      float D = X.distance(I, Medoids[C]);
+      if (D < BestDistance) {
+        Best = C;
+        BestDistance = D;
+      }
+    }
+    Assignment[I] = Best;
+    Distances[I] = std::sqrt(BestDistance);
+  });
+
+  double Total = 0;
+  for (float D : Distances)
+    Total += D;
+  return Total;
+}
+
+std::vector<unsigned> KMedoids::sample(ArrayRef<unsigned> Members,
+                                       unsigned N) {
+  std::vector<unsigned> Ret(Members.begin(), Members.end());
+  if (Ret.size() <= N)
+    return Ret;
+  // Partial Fisher-Yates shuffle
+  for (unsigned I = 0; I < N; ++I)
+    std::swap(Ret[I], Ret[std::uniform_int_distribution<unsigned>(
+                          I, Ret.size() - 1)(Gen)]);
+  Ret.resize(N);
+  return Ret;
+}
+
+unsigned KMedoids::findMedoid(ArrayRef<unsigned> Candidates,
+                              ArrayRef<unsigned> Eval) const {
+  unsigned Best = Candidates.front();
+  double BestCost = INFINITY;
+  for (unsigned Candidate : Candidates) {
+    double Cost = 0;
+    for (unsigned Row : Eval) {
+      Cost += std::sqrt(X.distance(Candidate, Row));
+      if (Cost >= BestCost)
+        break;
+    }
+    if (Cost < BestCost) {
+      Best = Candidate;
+      BestCost = Cost;
+    }
+  }
+  return Best;
+}
+
+unsigned KMedoids::run(unsigned MaxIterations) {
+  if (X.getRows() == 0)
+    return 0;
+  seed();
+
+  unsigned Iteration = 0;
+  while (true) {
+    double Cost = assign();
+    MODEBUG(dbgs() << "[KMedoids] Iteration " << Iteration << ", cost "
+                   << Cost << "\n");
+    if (Iteration++ == MaxIterations)
+      break;
+
+    std::vector<std::vector<unsigned>> Members(Medoids.size());
+    for (unsigned I = 0; I < Assignment.size(); ++I)
+      Members[Assignment[I]].push_back(I);
+
+    // Sample serially so that the result only depends on the seed.
+    std::vector<std::vector<unsigned>> Candidates, Eval;
+    for (unsigned C = 0; C < Medoids.size(); ++C) {
+      Candidates.push_back(sample(Members[C], NumCandidates));
+      // The current medoid stays if nothing is better.
+      Candidates.back().insert(Candidates.back().begin(), Medoids[C]);
+      Eval.push_back(sample(Members[C], NumEvaluated));
+    }
+
+    std::vector<unsigned> NewMedoids(Medoids.size());
+    parallelFor(Medoids.size(), [&](unsigned C) {
+      NewMedoids[C] = findMedoid(Candidates[C], Eval[C]);
+    });
+
+    if (NewMedoids == Medoids)
+      break;
+    Medoids = std::move(NewMedoids);
+  }
+  return Iteration;
+}
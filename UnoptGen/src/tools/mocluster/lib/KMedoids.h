@@ -0,0 +1,55 @@
+#pragma once
+
+#include "FeatureMatrix.h"
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/Support/ThreadPool.h>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace llvm {
+
+/*
+ * k-medoids over the rows of a feature matrix: seed the medoids like
+ * k-means++, then alternate between assigning every row to its nearest medoid
+ * and moving every medoid to the member that minimizes the distance to the
+ * rest of its cluster.
+ *
+ * Large clusters are handled like CLARA: the new medoid is picked among a
+ * sample of the members, by its cost on another sample. A full pass is O(n*k)
+ * distances, so 100k findings take seconds.
+ */
+
+class KMedoids {
+public:
+  KMedoids(const FeatureMatrix &X, unsigned K, unsigned Seed, ThreadPool &Pool)
+      : X(X), K(K), Gen(Seed), Pool(Pool) {}
+
+  // Return the number of iterations until the medoids stopped moving.
+  unsigned run(unsigned MaxIterations = 30);
+
+  ArrayRef<unsigned> getMedoids() const { return Medoids; }
+  // The index into getMedoids() of the cluster of every row
+  ArrayRef<unsigned> getAssignment() const { return Assignment; }
+
+private:
+  void seed();
+  // Return the total distance of the rows to their medoids.
+  double assign();
+  // Return the candidate with the least total distance to the rows in Eval.
+  unsigned findMedoid(ArrayRef<unsigned> Candidates,
+                      ArrayRef<unsigned> Eval) const;
+  std::vector<unsigned> sample(ArrayRef<unsigned> Members, unsigned N);
+  void parallelFor(unsigned N, std::function<void(unsigned)> Fn);
+
+  const FeatureMatrix &X;
+  unsigned K;
+  std::mt19937 Gen;
+  ThreadPool &Pool;
+
+  std::vector<unsigned> Medoids;
+  std::vector<unsigned> Assignment;
+  std::vector<float> Distances;
+};
+
+} // namespace llvm
@@ -0,0 +1,115 @@
+#include "lib/FeatureMatrix.h"
+#include "lib/KMedoids.h"
+#include "llvm/Support/WithColor.h"
+#include <cmath>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/LineIterator.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+
+/*
+ * Group findings by likely root cause: cluster the feature vectors put by
+ * `mo-diff -batch` with k-medoids, and report the medoid of every cluster as
+ * its representative.
+ */
+
+cl::OptionCategory MOClusterOptions("MOCluster Options");
+
+static cl::opt<std::string> InputFile(cl::Positional,
+                                      cl::desc("<feature vectors>"),
+                                      cl::Required, cl::cat(MOClusterOptions));
+static cl::opt<unsigned>
+    NumClusters("k", cl::desc("Number of clusters, sqrt(n/2) by default"),
+                cl::init(0), cl::cat(MOClusterOptions));
+static cl::opt<unsigned> Seed("seed", cl::desc("Seed of the clustering"),
+                              cl::init(0), cl::cat(MOClusterOptions));
+static cl::opt<unsigned> Jobs("j", cl::desc("Number of threads"), cl::init(0),
+                              cl::cat(MOClusterOptions));
+static cl::opt<std::string>
+    OutputFile("o", cl::desc("File of the cluster of every finding"),
+               cl::cat(MOClusterOptions));
+
+int main(int Argc, char **Argv) {
+  cl::HideUnrelatedOptions({&MOClusterOptions, &getColorCategory()});
+  cl::ParseCommandLineOptions(Argc, Argv);
+
+  auto Buffer = MemoryBuffer::getFile(InputFile);
+  if (!Buffer) {
+    errs() << "Cannot read " << InputFile << "\n";
+    return 1;
+  }
+
+  // Every line is a case and its features; lines starting with '#' name the
+  // features.
+  std::vector<std::string> Cases;
+  std::vector<SmallVector<StringRef, 128>> Fields;
+  for (line_iterator It(**Buffer, /*SkipBlanks=*/true, '#'); !It.is_at_end();
+       ++It) {
+    Fields.emplace_back();
+    It->split(Fields.back(), ' ', -1, /*KeepEmpty=*/false);
+    Cases.push_back(Fields.back().front().str());
+  }
+  if (Cases.empty())
+    return 0;
+
+  unsigned Cols = Fields.front().size() - 1;
+  FeatureMatrix X(Cases.size(), Cols);
+  for (unsigned R = 0; R < Cases.size(); ++R) {
+    if (Fields[R].size() != Cols + 1) {
+      errs() << "Malformed features of " << Cases[R] << "\n";
+      return 1;
+    }
+    for (unsigned C = 0; C < Cols; ++C)
+      if (!to_float(Fields[R][C + 1], X.row(R)[C])) {
+        errs() << "Malformed features of " << Cases[R] << "\n";
+        return 1;
+      }
+  }
+  X.standardize();
+
+  unsigned K = NumClusters;
+  if (!K)
+    K = std::max(1.0, std::sqrt(Cases.size() / 2.0));
+
+  ThreadPool Pool(Jobs ? hardware_concurrency(Jobs) : hardware_concurrency());
+  KMedoids Clustering(X, K, Seed, Pool);
+  Clustering.run();
+
+  ArrayRef<unsigned> Medoids = Clustering.getMedoids();
+  ArrayRef<unsigned> Assignment = Clustering.getAssignment();
+  std::vector<unsigned> Sizes(Medoids.size());
+  for (unsigned C : Assignment)
+    ++Sizes[C];
+
+  // Largest clusters first, they are the most common root causes.
+  std::vector<unsigned> Order(Medoids.size());
+  for (unsigned C = 0; C < Order.size(); ++C)
+    Order[C] = C;
+  llvm::stable_sort(Order,
+                    [&](unsigned A, unsigned B) { return Sizes[A] > Sizes[B]; });
+  std::vector<unsigned> Rank(Medoids.size());
+  for (unsigned I = 0; I < Order.size(); ++I)
+    Rank[Order[I]] = I;
+
+  for (unsigned C : Order)
+    outs() << "cluster " << Rank[C] << " size " << Sizes[C] << " medoid "
+           << Cases[Medoids[C]] << "\n";
+
+  if (!OutputFile.empty()) {
+    std::error_code EC;
+    raw_fd_ostream Out(OutputFile, EC, sys::fs::OF_Text);
+    if (EC) {
+      errs() << "Cannot write " << OutputFile << "\n";
+      return 1;
+    }
+    for (unsigned R = 0; R < Cases.size(); ++R)
+      Out << Cases[R] << " " << Rank[Assignment[R]] << " "
+          << (Medoids[Assignment[R]] == R) << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,65 @@
+#include "MinHash.h"
+#include <llvm/Support/xxhash.h>
+
+using namespace llvm;
+
+// A fixed family of hash functions, one per row: mix the shingle with a
+// per-row seed. The seeds are constant so that signatures are comparable
+// across runs.
+static uint64_t mix(uint64_t X) {
+  // splitmix64 finalizer
+  X += 0x9e3779b97f4a7c15ULL;
+  X = (X ^ (X >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  X = (X ^ (X >> 27)) * 0x94d049bb133111ebULL;
+  return X ^ (X >> 31);
+}
+
+MinHashSignature llvm::computeMinHash(ArrayRef<uint64_t> Shingles) {
+  static const std::array<uint64_t, MinHashSize> Seeds = [] {
+    std::array<uint64_t, MinHashSize> Ret;
+    for (unsigned I = 0; I < MinHashSize; ++I)
+      Ret[I] = mix(I + 1);
+    return Ret;
+  }();
+
+  MinHashSignature Sig;
+  Sig.fill(~0ULL);
+  for (uint64_t Shingle : Shingles)
+    for (unsigned I = 0; I < MinHashSize; ++I)
+      Sig[I] = std::min(Sig[I], mix(Shingle ^ Seeds[I]));
+  return Sig;
+}
+
+double llvm::estimateSimilarity(const MinHashSignature &A,
+                                const MinHashSignature &B) {
+  unsigned Equal = 0;
+  for (unsigned I = 0; I < MinHashSize; ++I)
+    Equal += A[I] == B[I];
+  return (double)Equal / MinHashSize;
+}
+
+std::optional<unsigned> LSHIndex::insert(unsigned ID,
+                                         const MinHashSignature &Sig,
+                                         double Threshold) {
+  uint64_t BandHashes[MinHashBands];
+  for (unsigned Band = 0; Band < MinHashBands; ++Band)
+    BandHashes[Band] = xxHash64(ArrayRef<uint8_t>(
+        reinterpret_cast<const uint8_t *>(&Sig[Band * MinHashRows]),
+        MinHashRows * sizeof(uint64_t)));
+
+  for (unsigned Band = 0; Band < MinHashBands; ++Band) {
+    auto It = Buckets[Band].find(BandHashes[Band]);
+    if (It == Buckets[Band].end())
+      continue;
+    for (unsigned Other : It->second)
+      if (estimateSimilarity(Sig, Signatures[Other]) >= Threshold)
+        return Other;
+  }
+
+  // A new distinct item. Only distinct items are kept in the buckets, so they
+  // stay small even with many duplicates.
+  Signatures[ID] = Sig;
+  for (unsigned Band = 0; Band < MinHashBands; ++Band)
+    Buckets[Band][BandHashes[Band]].push_back(ID);
+  return std::nullopt;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <optional>
+#include <vector>
+
+namespace llvm {
+
+/*
+ * MinHash signatures of shingle sets, and an LSH index over them: the
+ * signature is split into bands, and two sets become candidates if any band
+ * is equal. With 32 bands of 4 rows, sets with a Jaccard similarity of 0.8
+ * collide in some band with a probability above 0.99.
+ */
+
+constexpr unsigned MinHashBands = 32;
+constexpr unsigned MinHashRows = 4;
+constexpr unsigned MinHashSize = MinHashBands * MinHashRows;
+
+typedef std::array<uint64_t, MinHashSize> MinHashSignature;
+
+MinHashSignature computeMinHash(ArrayRef<uint64_t> Shingles);
+
+// Estimated Jaccard similarity of the sets behind two signatures.
+double estimateSimilarity(const MinHashSignature &A,
+                          const MinHashSignature &B);
+
+class LSHIndex {
+public:
+  // Add the signature of item ID, and return the ID of an earlier item whose
+  // estimated similarity is at least Threshold, if any.
+  std::optional<unsigned> insert(unsigned ID, const MinHashSignature &Sig,
+                                 double Threshold);
+
+private:
+  // Signatures of the items added so far, by ID
+  DenseMap<unsigned, MinHashSignature> Signatures;
+  // For every band, the items that are not near-duplicates of each other,
+  // keyed by the hash of the band.
+  std::array<DenseMap<uint64_t, std::vector<unsigned>>, MinHashBands> Buckets;
+};
+
+} // namespace llvm
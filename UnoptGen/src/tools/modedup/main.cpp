@@ -0,0 +1,217 @@
+#include "lib/MinHash.h"
+#include "tools/moreduce/lib/DiffEngine.h"
+#include "transforms/IRNormalizer/IRNormalizer.h"
+#include "utils/Debug.h"
+#include "utils/Files.h"
+#include "utils/Hash.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/WithColor.h"
+#include <llvm/ADT/Hashing.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/Threading.h>
+
+using namespace llvm;
+
+/*
+ * Deduplicate the findings in a directory of cases, each holding an
+ * original_opt.ll and a mutated_opt.ll. Two cases are duplicates if both of
+ * their modules are structurally equal, or if the regions where DiffEngine
+ * tells the pair apart are near-duplicates by MinHash.
+ */
+
+cl::OptionCategory MODedupOptions("MODedup Options");
+
+static cl::opt<std::string> InputDir(cl::Positional,
+                                     cl::desc("<dir of cases>"), cl::Required,
+                                     cl::cat(MODedupOptions));
+static cl::opt<double>
+    Threshold("threshold",
+              cl::desc("Similarity of the diff regions of near-duplicates"),
+              cl::init(0.9), cl::cat(MODedupOptions));
+static cl::opt<bool> Remove("remove", cl::desc("Remove duplicated cases"),
+                            cl::cat(MODedupOptions));
+static cl::opt<unsigned> Jobs("j",
+                              cl::desc("Number of cases to read concurrently"),
+                              cl::init(0), cl::cat(MODedupOptions));
+
+// Consecutive instructions of the diff region per shingle
+static const unsigned ShingleSize = 3;
+
+struct CaseSummary {
+  bool Valid = false;
+  uint64_t ExactHash = 0;
+  // Signature of the diff region, if there is one
+  std::optional<MinHashSignature> Signature;
+};
+
+static std::unique_ptr<Module> readModule(LLVMContext &Context,
+                                          StringRef Name) {
+  SMDiagnostic Diag;
+  std::unique_ptr<Module> M = ParseIRFile(Name.str(), Diag, Context);
+  if (!M)
+    Diag.print("modedup", errs());
+  return M;
+}
+
+// The shape of an operand: what kind of value it is, but not which one.
+static hash_code hashOperandShape(DiffEngine &Engine, const Value *V) {
+  if (auto *I = dyn_cast<Instruction>(V))
+    return hash_combine(1, I->getOpcode(), Engine.Values.contains(V));
+  if (isa<Argument>(V))
+    return hash_combine(2);
+  if (isa<GlobalValue>(V))
+    return hash_combine(3);
+  if (isa<BasicBlock>(V))
+    return hash_combine(4, Engine.Values.contains(V));
+  if (auto *C = dyn_cast<ConstantInt>(V))
+    // Small constants are often the point of a missed optimization.
+    return hash_combine(5, C->getValue().getSignificantBits() <= 8
+                               ? C->getSExtValue()
+                               : 0);
+  return hash_combine(6, V->getValueID());
+}
+
+static uint64_t hashInstShape(DiffEngine &Engine, const Instruction &I) {
+  hash_code Hash = hash_combine(I.getOpcode(), I.getType()->getTypeID(),
+                                I.getType()->getScalarSizeInBits());
+  if (auto *Cmp = dyn_cast<CmpInst>(&I))
+    Hash = hash_combine(Hash, Cmp->getPredicate());
+  for (const Value *Op : I.operands())
+    Hash = hash_combine(Hash, hashOperandShape(Engine, Op));
+  return Hash;
+}
+
+// Shingle the instructions DiffEngine left unmatched in M, in program order.
+static void collectShingles(DiffEngine &Engine, const Module &M,
+                            uint64_t Side, std::vector<uint64_t> &Shingles) {
+  std::vector<uint64_t> Tokens;
+  for (const Function &F : M)
+    for (const BasicBlock &BB : F)
+      for (const Instruction &I : BB)
+        if (!Engine.Values.contains(&I))
+          Tokens.push_back(hashInstShape(Engine, I));
+
+  if (Tokens.empty())
+    return;
+  if (Tokens.size() < ShingleSize) {
+    Shingles.push_back(
+        hash_combine(Side, hash_combine_range(Tokens.begin(), Tokens.end())));
+    return;
+  }
+  for (size_t I = 0; I + ShingleSize <= Tokens.size(); ++I) {
+    auto Begin = Tokens.begin() + I;
+    Shingles.push_back(hash_combine(
+        Side, hash_combine_range(Begin, Begin + ShingleSize)));
+  }
+}
+
+static CaseSummary summarize(StringRef CaseDir) {
+  CaseSummary Summary;
+  SmallString<128> OriginalPath(CaseDir), MutatedPath(CaseDir);
+  sys::path::append(OriginalPath, "original_opt.ll");
+  sys::path::append(MutatedPath, "mutated_opt.ll");
+
+  // LLVMContext is not thread-safe, every case owns one.
+  LLVMContext Context;
+  auto Original = readModule(Context, OriginalPath);
+  auto Mutated = readModule(Context, MutatedPath);
+  if (!Original || !Mutated)
+    return Summary;
+
+  // Equivalent modules differing only in block layout, operand order or
+  // metadata are exact duplicates.
+  normalizeModule(*Original);
+  normalizeModule(*Mutated);
+
+  Summary.Valid = true;
+  Summary.ExactHash =
+      hash_combine(hashModule(*Original), hashModule(*Mutated));
+
+  DiffEngine Engine;
+  Engine.diff(Original.get(), Mutated.get());
+  std::vector<uint64_t> Shingles;
+  collectShingles(Engine, *Original, 0, Shingles);
+  collectShingles(Engine, *Mutated, 1, Shingles);
+  if (!Shingles.empty())
+    Summary.Signature = computeMinHash(Shingles);
+  return Summary;
+}
+
+// Case directories in numeric order, so that the earliest finding of a
+// cluster is the one kept.
+static std::vector<std::string> listCases(StringRef Dir) {
+  std::vector<std::string> Cases;
+  std::error_code EC;
+  for (sys::fs::directory_iterator It(Dir, EC), End; It != End && !EC;
+       It.increment(EC))
+    if (sys::fs::is_directory(It->path()))
+      Cases.push_back(It->path());
+
+  auto Key = [](const std::string &Path) {
+    unsigned long long Index;
+    StringRef Name = sys::path::filename(Path);
+    if (getAsUnsignedInteger(Name, 10, Index))
+      Index = ~0ULL;
+    return std::make_pair(Index, Name);
+  };
+  llvm::sort(Cases, [&](const std::string &A, const std::string &B) {
+    return Key(A) < Key(B);
+  });
+  return Cases;
+}
+
+int main(int Argc, char **Argv) {
+  cl::HideUnrelatedOptions({&MODedupOptions, &getColorCategory()});
+  cl::ParseCommandLineOptions(Argc, Argv);
+
+  std::vector<std::string> Cases = listCases(InputDir);
+  std::vector<CaseSummary> Summaries(Cases.size());
+  {
+    ThreadPool Pool(Jobs ? hardware_concurrency(Jobs) : hardware_concurrency());
+    for (unsigned I = 0; I < Cases.size(); ++I)
+      Pool.async([&, I] { Summaries[I] = summarize(Cases[I]); });
+    Pool.wait();
+  }
+
+  // Clustering is cheap next to parsing, so it is done serially in case
+  // order.
+  DenseMap<uint64_t, unsigned> ExactSeen;
+  LSHIndex Index;
+  unsigned NumDuplicates = 0;
+  for (unsigned I = 0; I < Cases.size(); ++I) {
+    CaseSummary &Summary = Summaries[I];
+    if (!Summary.Valid)
+      continue;
+
+    std::optional<unsigned> Original;
+    auto [It, Inserted] = ExactSeen.try_emplace(Summary.ExactHash, I);
+    if (!Inserted)
+      Original = It->second;
+    else if (Summary.Signature) {
+      Original = Index.insert(I, *Summary.Signature, Threshold);
+      // Later exact duplicates belong to the kept case as well.
+      if (Original)
+        It->second = *Original;
+    }
+
+    if (!Original)
+      continue;
+
+    ++NumDuplicates;
+    outs() << Cases[I] << " duplicates " << Cases[*Original] << "\n";
+    if (Remove && sys::fs::remove_directories(Cases[I]))
+      errs() << "Cannot remove " << Cases[I] << "\n";
+  }
+
+  outs() << "======Result======\n";
+  outs() << "Deduplicate " << NumDuplicates << " cases\n";
+  return 0;
+}
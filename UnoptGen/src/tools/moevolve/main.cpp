@@ -0,0 +1,426 @@
+#include "engine/Mutator.h"
+#include "engine/Optimizer.h"
+#include "indicators/IndicatorSet.h"
+#include "indicators/StaticProfileIndicator.h"
+#include "utils/Files.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/WithColor.h"
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <random>
+
+using namespace llvm;
+
+/*
+ * Evolve mutation pipelines that widen the gap between an input and its
+ * mutant after optimization: the fitness of a pipeline is the static profile
+ * cost the optimized mutant saves over the optimized input, relative to the
+ * cost of every function and summed over them.
+ *
+ * A genome is a list of passes of the Mutator table given by -pipeline-type,
+ * each with its own seed, so crossover and mutation keep the decisions of the
+ * passes they do not touch. The population is split into islands that evolve
+ * on their own threads, each with its own LLVMContext, and the best genomes of
+ * an island migrate to the next one every few generations. Every genome is
+ * cloned, mutated and optimized in-process.
+ *
+ * Crashes are not guarded, since only one CrashGuard may run at a time; triage
+ * them with mocampaign.
+ */
+
+cl::OptionCategory MOEvolveOptions("MOEvolve Options");
+
+static cl::opt<std::string> InputFile(cl::Positional, cl::desc("<input file>"),
+                                      cl::Required, cl::cat(MOEvolveOptions));
+static cl::opt<std::string>
+    OutputDir("o", cl::desc("Directory to write the best mutant to"),
+              cl::Required, cl::cat(MOEvolveOptions));
+static cl::opt<unsigned> PopulationSize("population",
+                                        cl::desc("Genomes of all islands"),
+                                        cl::init(256),
+                                        cl::cat(MOEvolveOptions));
+static cl::opt<unsigned> Generations("generations",
+                                     cl::desc("Generations to evolve"),
+                                     cl::init(20), cl::cat(MOEvolveOptions));
+static cl::opt<unsigned>
+    NumIslands("islands", cl::desc("Islands, one per core if 0"),
+               cl::init(0), cl::cat(MOEvolveOptions));
+static cl::opt<unsigned>
+    MigrationInterval("migration-interval",
+                      cl::desc("Generations between migrations"),
+                      cl::init(5), cl::cat(MOEvolveOptions));
+static cl::opt<unsigned>
+    NumMigrants("migrants",
+                cl::desc("Best genomes sent to the next island"),
+                cl::init(2), cl::cat(MOEvolveOptions));
+static cl::opt<double>
+    MutationRate("mutation-rate",
+                 cl::desc("Probability that a child is mutated"),
+                 cl::init(0.5), cl::cat(MOEvolveOptions));
+static cl::opt<int> MaxPasses("m", cl::desc("Max number of passes to run"),
+                              cl::init(16), cl::cat(MOEvolveOptions));
+static cl::opt<std::string>
+    OriginalPipeline("original-opt", cl::desc("Optimization of the input"),
+                     cl::init("-O3"), cl::cat(MOEvolveOptions));
+static cl::opt<std::string>
+    MutantPipeline("mutant-opt", cl::desc("Optimization of the mutants"),
+                   cl::init("-O3"), cl::cat(MOEvolveOptions));
+static cl::opt<unsigned> EvolveSeed("seed", cl::desc("Seed of the evolution"),
+                                    cl::cat(MOEvolveOptions));
+
+namespace {
+
+struct Gene {
+  std::string Pass;
+  ulong Seed;
+};
+
+struct Genome {
+  std::vector<Gene> Genes;
+  std::optional<double> Fitness;
+
+  std::vector<std::string> getPipeline() const {
+    std::vector<std::string> Pipeline;
+    for (const Gene &G : Genes)
+      Pipeline.push_back(G.Pass);
+    return Pipeline;
+  }
+  std::vector<ulong> getSeeds() const {
+    std::vector<ulong> Seeds;
+    for (const Gene &G : Genes)
+      Seeds.push_back(G.Seed);
+    return Seeds;
+  }
+};
+
+class Island {
+public:
+  Island(StringRef Bitcode, const StringMap<double> &InputCosts,
+         unsigned Size, ulong Seed);
+
+  // Evolve the island for a number of generations, evaluating every new
+  // genome.
+  void evolve(unsigned NumGenerations);
+
+  // Best genomes first
+  ArrayRef<Genome> getPopulation() const { return Population; }
+  // Replace the worst genomes by Migrants.
+  void receive(ArrayRef<Genome> Migrants);
+
+private:
+  Gene getRandomGene();
+  Genome getRandomGenome();
+  const Genome &select();
+  Genome crossover(const Genome &L, const Genome &R);
+  void mutate(Genome &G);
+  void evaluate(Genome &G);
+  void sort();
+
+  LLVMContext Context;
+  std::unique_ptr<Module> Input;
+  const StringMap<double> &InputCosts;
+  std::vector<Genome> Population;
+  std::mt19937_64 Gen;
+  std::vector<std::pair<std::string, int>> Passes;
+  std::discrete_distribution<> PassDist;
+};
+
+} // namespace
+
+// Gain of the optimized module M over the optimized input
+static double getGain(Module &M, const StringMap<double> &InputCosts) {
+  double Gain = 0;
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    auto It = InputCosts.find(F.getName());
+    if (It == InputCosts.end())
+      continue;
+    double Cost = StaticProfileIndicator::getCost(F);
+    Gain += (It->second - Cost) / std::max(It->second, 1.0);
+  }
+  return Gain;
+}
+
+// Mutate and optimize a clone of M as G says. Return nullptr if the mutant
+// cannot be optimized.
+static std::unique_ptr<Module>
+mutateAndOptimize(const Module &M, const Genome &G,
+                  std::unique_ptr<Module> *Mutated) {
+  std::unique_ptr<Module> Mutant = CloneModule(M);
+  if (!G.Genes.empty()) {
+    Mutator Mutator(MaxPasses, "", "");
+    Mutator.setPipeline(G.getPipeline());
+    Mutator.setSeeds(G.getSeeds());
+    Mutator.mutate(*Mutant);
+  }
+  if (Mutated)
+    *Mutated = CloneModule(*Mutant);
+  if (Optimizer(MutantPipeline).run(*Mutant))
+    return nullptr;
+  return Mutant;
+}
+
+Island::Island(StringRef Bitcode, const StringMap<double> &InputCosts,
+               unsigned Size, ulong Seed)
+    : Input(ParseBitcode(Bitcode, Context)), InputCosts(InputCosts), Gen(Seed),
+      Passes(Mutator::getPasses()) {
+  std::vector<int> Weights;
+  for (auto &[_, Weight] : Passes)
+    Weights.push_back(Weight);
+  PassDist = std::discrete_distribution<>(Weights.begin(), Weights.end());
+
+  for (unsigned I = 0; I < Size; ++I)
+    Population.push_back(getRandomGenome());
+}
+
+Gene Island::getRandomGene() { return {Passes[PassDist(Gen)].first, Gen()}; }
+
+Genome Island::getRandomGenome() {
+  Genome G;
+  unsigned Length = std::uniform_int_distribution<>(1, MaxPasses)(Gen);
+  for (unsigned I = 0; I < Length; ++I)
+    G.Genes.push_back(getRandomGene());
+  return G;
+}
+
+// Tournament of three
+const Genome &Island::select() {
+  std::uniform_int_distribution<size_t> Dist(0, Population.size() - 1);
+  const Genome *Best = &Population[Dist(Gen)];
+  for (unsigned I = 1; I < 3; ++I) {
+    const Genome &Other = Population[Dist(Gen)];
+    if (*Other.Fitness > *Best->Fitness)
+      Best = &Other;
+  }
+  return *Best;
+}
+
+// A head of L and a tail of R, cut at their own points
+Genome Island::crossover(const Genome &L, const Genome &R) {
+  Genome Child;
+  size_t LCut = std::uniform_int_distribution<size_t>(0, L.Genes.size())(Gen);
+  size_t RCut = std::uniform_int_distribution<size_t>(0, R.Genes.size())(Gen);
+  Child.Genes.assign(L.Genes.begin(), L.Genes.begin() + LCut);
+  Child.Genes.insert(Child.Genes.end(), R.Genes.begin() + RCut,
+                     R.Genes.end());
+  if (Child.Genes.size() > (size_t)MaxPasses)
+    Child.Genes.resize(MaxPasses);
+  return Child;
+}
+
+// Replace, reseed, insert or remove a pass.
+void Island::mutate(Genome &G) {
+  size_t Size = G.Genes.size();
+  unsigned Kind = std::uniform_int_distribution<>(0, 3)(Gen);
+  if (Size == 0)
+    Kind = 2;
+  else if (Size >= (size_t)MaxPasses && Kind == 2)
+    Kind = 0;
+  size_t Pos =
+      std::uniform_int_distribution<size_t>(0, Size ? Size - 1 : 0)(Gen);
+  switch (Kind) {
+  case 0:
+    G.Genes[Pos] = getRandomGene();
+    break;
+  case 1:
+    G.Genes[Pos].Seed = Gen();
+    break;
+  case 2:
+    G.Genes.insert(G.Genes.begin() + (Size ? Pos + 1 : 0), getRandomGene());
+    break;
+  case 3:
+    G.Genes.erase(G.Genes.begin() + Pos);
+    break;
+  }
+}
+
+void Island::evaluate(Genome &G) {
+  if (G.Fitness)
+    return;
+  std::unique_ptr<Module> Optimized = mutateAndOptimize(*Input, G, nullptr);
+  G.Fitness = Optimized ? getGain(*Optimized, InputCosts) : -1e9;
+}
+
+void Island::sort() {
+  llvm::stable_sort(Population, [](const Genome &L, const Genome &R) {
+    return *L.Fitness > *R.Fitness;
+  });
+}
+
+void Island::evolve(unsigned NumGenerations) {
+  for (Genome &G : Population)
+    evaluate(G);
+  sort();
+
+  for (unsigned I = 0; I < NumGenerations; ++I) {
+    // The best two survive as they are.
+    std::vector<Genome> Next(Population.begin(),
+                             Population.begin() +
+                                 std::min<size_t>(2, Population.size()));
+    std::bernoulli_distribution Mutates(MutationRate);
+    while (Next.size() < Population.size()) {
+      Genome Child = crossover(select(), select());
+      if (Child.Genes.empty() || Mutates(Gen))
+        mutate(Child);
+      evaluate(Child);
+      Next.push_back(std::move(Child));
+    }
+    Population = std::move(Next);
+    sort();
+  }
+}
+
+void Island::receive(ArrayRef<Genome> Migrants) {
+  size_t Count = std::min(Migrants.size(), Population.size());
+  std::copy(Migrants.begin(), Migrants.begin() + Count,
+            Population.end() - Count);
+  sort();
+}
+
+static std::unique_ptr<Module> readModule(LLVMContext &Context,
+                                          StringRef Name) {
+  SMDiagnostic Diag;
+  std::unique_ptr<Module> M = ParseIRFile(Name.str(), Diag, Context);
+  if (!M)
+    Diag.print("moevolve", errs());
+  return M;
+}
+
+// Functions the optimized mutant is better in by all the -indicators, like
+// mocampaign.
+static std::vector<std::string> classify(Module &OriginalOpt,
+                                         Module &MutatedOpt) {
+  std::vector<NamedIndicator> Indicators = createIndicators();
+  std::vector<std::string> Funcs;
+  for (Function &L : MutatedOpt) {
+    Function *R = OriginalOpt.getFunction(L.getName());
+    if (L.isDeclaration() || !R || R->isDeclaration())
+      continue;
+    if (all_of(Indicators, [&](NamedIndicator &I) {
+          return I.Check->worth(L, *R) > 0;
+        }))
+      Funcs.push_back(L.getName().str());
+  }
+  return Funcs;
+}
+
+// Write the best genome like a finding of mocampaign, with the seed of every
+// pass in seeds.
+static int writeBest(const Genome &Best, Module &Original,
+                     Module &OriginalOpt) {
+  std::unique_ptr<Module> Mutated;
+  std::unique_ptr<Module> MutatedOpt =
+      mutateAndOptimize(Original, Best, &Mutated);
+  if (!MutatedOpt)
+    return -1;
+
+  sys::fs::create_directories(OutputDir);
+  auto Path = [](StringRef Name) {
+    SmallString<128> Path(OutputDir.getValue());
+    sys::path::append(Path, Name);
+    return std::string(Path);
+  };
+
+  std::vector<std::string> Seeds;
+  for (ulong Seed : Best.getSeeds())
+    Seeds.push_back(std::to_string(Seed));
+  std::vector<std::string> Funcs = classify(OriginalOpt, *MutatedOpt);
+
+  WriteModule(Original, Path("original.ll"));
+  WriteModule(*Mutated, Path("mutated.ll"));
+  WriteModule(OriginalOpt, Path("original_opt.ll"));
+  WriteModule(*MutatedOpt, Path("mutated_opt.ll"));
+  WritePipeline(Path("pipeline"), Best.getPipeline());
+  WritePipeline(Path("seeds"), Seeds);
+  WriteFile(Path("func_names"), join(Funcs, "\n") + "\n");
+  WriteFile(Path("source_path.txt"), InputFile + "\n");
+  outs() << "Better in " << Funcs.size() << " functions by all indicators\n";
+  return 0;
+}
+
+int main(int Argc, char **Argv) {
+  cl::HideUnrelatedOptions(
+      {&MOEvolveOptions, &getIndicatorCategory(), &getColorCategory()});
+  cl::ParseCommandLineOptions(Argc, Argv);
+
+  LLVMContext Context;
+  std::unique_ptr<Module> Original = readModule(Context, InputFile);
+  if (!Original)
+    return 1;
+  std::unique_ptr<Module> OriginalOpt = CloneModule(*Original);
+  if (Optimizer(OriginalPipeline).run(*OriginalOpt))
+    return 1;
+
+  StringMap<double> InputCosts;
+  for (Function &F : *OriginalOpt)
+    if (!F.isDeclaration())
+      InputCosts[F.getName()] = StaticProfileIndicator::getCost(F);
+
+  if (!Generations || PopulationSize < 2) {
+    errs() << "Needs a generation and two genomes at least\n";
+    return 1;
+  }
+  if (MaxPasses <= 0) {
+    errs() << "Needs a pass per genome at least\n";
+    return 1;
+  }
+
+  // Two genomes per island at least
+  ThreadPoolStrategy Strategy = hardware_concurrency(NumIslands);
+  unsigned Count =
+      std::min<unsigned>(Strategy.compute_thread_count(), PopulationSize / 2);
+  std::mt19937_64 SeedGen(EvolveSeed.getNumOccurrences()
+                              ? EvolveSeed
+                              : std::random_device()());
+  std::string Bitcode = WriteBitcode(*Original);
+  std::vector<std::unique_ptr<Island>> Islands;
+  // The first islands take the remainder of the population.
+  for (unsigned I = 0; I < Count; ++I)
+    Islands.push_back(std::make_unique<Island>(
+        Bitcode, InputCosts,
+        PopulationSize / Count + (I < PopulationSize % Count), SeedGen()));
+
+  ThreadPool Pool(Strategy);
+  unsigned Interval = std::max(1u, MigrationInterval.getValue());
+  for (unsigned Done = 0; Done < Generations;) {
+    unsigned Epoch = std::min(Interval, Generations - Done);
+    for (auto &I : Islands)
+      Pool.async([&I, Epoch] { I->evolve(Epoch); });
+    Pool.wait();
+    Done += Epoch;
+
+    // Every island sends its best to the next one, around the ring.
+    std::vector<std::vector<Genome>> Migrants;
+    for (auto &I : Islands)
+      Migrants.emplace_back(I->getPopulation().take_front(
+          std::min<size_t>(NumMigrants, I->getPopulation().size())));
+    if (Islands.size() > 1)
+      for (unsigned I = 0; I < Islands.size(); ++I)
+        Islands[(I + 1) % Islands.size()]->receive(Migrants[I]);
+
+    double Best = -1e9;
+    for (auto &I : Islands)
+      Best = std::max(Best, *I->getPopulation().front().Fitness);
+    outs() << "Generation " << Done << ": best " << format("%.4f", Best)
+           << "\n";
+  }
+
+  const Genome *Best = nullptr;
+  for (auto &I : Islands) {
+    const Genome &G = I->getPopulation().front();
+    if (!Best || *G.Fitness > *Best->Fitness)
+      Best = &G;
+  }
+  outs() << "Best pipeline: " << join(Best->getPipeline(), ",") << "\n";
+  return writeBest(*Best, *Original, *OriginalOpt) ? 1 : 0;
+}
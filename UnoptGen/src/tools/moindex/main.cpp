@@ -0,0 +1,81 @@
+#include "engine/SiteIndex.h"
+#include "utils/Files.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/WithColor.h"
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/Path.h>
+
+using namespace llvm;
+
+/*
+ * Index the mutation sites of a corpus once, for mocampaign -site-index: the
+ * sites of every counted pass on every function of every input. The inputs
+ * are keyed by their path relative to the corpus, and those already in the
+ * index are not read again unless -rebuild is given.
+ */
+
+cl::OptionCategory MOIndexOptions("MOIndex Options");
+
+static cl::opt<std::string> InputDir(cl::Positional,
+                                     cl::desc("<dir of inputs>"), cl::Required,
+                                     cl::cat(MOIndexOptions));
+static cl::opt<std::string> IndexPath("o", cl::desc("Index to update"),
+                                      cl::Required, cl::cat(MOIndexOptions));
+static cl::opt<bool> Rebuild("rebuild",
+                             cl::desc("Index the indexed inputs again"),
+                             cl::cat(MOIndexOptions));
+
+int main(int Argc, char **Argv) {
+  cl::HideUnrelatedOptions({&MOIndexOptions, &getColorCategory()});
+  cl::ParseCommandLineOptions(Argc, Argv);
+
+  SiteIndex Index;
+  if (!Rebuild && sys::fs::exists(IndexPath) && !Index.read(IndexPath)) {
+    WithColor::error() << "Cannot read " << IndexPath << "\n";
+    return -1;
+  }
+
+  std::vector<std::string> Inputs;
+  std::error_code EC;
+  for (sys::fs::recursive_directory_iterator It(InputDir, EC), End;
+       It != End && !EC; It.increment(EC))
+    if (sys::path::extension(It->path()) == ".ll")
+      Inputs.push_back(It->path());
+  llvm::sort(Inputs);
+
+  unsigned NumIndexed = 0;
+  for (unsigned I = 0; I < Inputs.size(); ++I) {
+    SmallString<128> Name(Inputs[I]);
+    sys::path::replace_path_prefix(Name, InputDir, "");
+    StringRef Key = sys::path::relative_path(Name);
+    if (Index.contains(Key))
+      continue;
+
+    LLVMContext Context;
+    SMDiagnostic Diag;
+    std::unique_ptr<Module> M = ParseIRFile(Inputs[I], Diag, Context);
+    if (!M) {
+      Diag.print("moindex", errs());
+      continue;
+    }
+    Index.add(Key, *M);
+    ++NumIndexed;
+
+    outs() << "\rProgress: [" << I + 1 << "/" << Inputs.size() << "]";
+    outs().flush();
+  }
+  outs() << "\n";
+
+  if (!Index.write(IndexPath)) {
+    WithColor::error() << "Cannot write " << IndexPath << "\n";
+    return -1;
+  }
+  outs() << "Indexed " << NumIndexed << " inputs, " << Index.getNumInputs()
+         << " in total, with " << format("%.1f", Index.getMeanSites())
+         << " sites per input\n";
+  return 0;
+}
@@ -0,0 +1,243 @@
+#include "engine/DeltaDebugger.h"
+#include "engine/Mutator.h"
+#include "tools/moreduce/lib/MissedOptOracle.h"
+#include "trace/Tracer.h"
+#include "utils/Debug.h"
+#include "utils/Files.h"
+#include "utils/Random.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/WithColor.h"
+#include <llvm/ADT/MapVector.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/xxhash.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+using namespace llvm;
+
+/*
+ * Minimize the random decisions of a mutant instead of its IR: run delta
+ * debugging over the gating decisions that mutated something, replaying the
+ * pipeline with the removed ones forced to leave the code alone, until the
+ * missed optimization needs every remaining one.
+ */
+
+cl::OptionCategory MOMinimizeOptions("MOMinimize Options");
+
+static cl::opt<std::string> InputFilename(cl::Positional,
+                                          cl::desc("<original file>"),
+                                          cl::Required,
+                                          cl::cat(MOMinimizeOptions));
+static cl::opt<std::string> FuncName("func", cl::desc("<function name>"),
+                                     cl::Required, cl::cat(MOMinimizeOptions));
+static cl::opt<std::string> SeedFile("seed", cl::desc("Seed file"),
+                                     cl::Required, cl::cat(MOMinimizeOptions));
+static cl::opt<std::string> PipelineFile("pipeline",
+                                         cl::desc("File of pipeline list"),
+                                         cl::Required,
+                                         cl::cat(MOMinimizeOptions));
+static cl::opt<std::string>
+    TraceFile("trace",
+              cl::desc("Trace of the mutant, recorded from the seed if absent"),
+              cl::cat(MOMinimizeOptions));
+static cl::opt<std::string>
+    OriginalOpt("original-opt", cl::desc("opt option for the original"),
+                cl::init("-O3"), cl::cat(MOMinimizeOptions));
+static cl::opt<std::string>
+    MutantOpt("mutant-opt", cl::desc("opt option for the mutant"),
+              cl::init("-O3"), cl::cat(MOMinimizeOptions));
+static cl::opt<unsigned>
+    Jobs("j", cl::desc("Number of candidates to check concurrently"),
+         cl::init(0), cl::cat(MOMinimizeOptions));
+static cl::opt<std::string> OutputDir("o",
+                                      cl::desc("Directory of minimized files"),
+                                      cl::init("."),
+                                      cl::cat(MOMinimizeOptions));
+
+static std::unique_ptr<Module> readModule(LLVMContext &Context,
+                                          StringRef Name) {
+  SMDiagnostic Diag;
+  std::unique_ptr<Module> M = ParseIRFile(Name.str(), Diag, Context);
+  if (!M)
+    Diag.print("mominimize", errs());
+  return M;
+}
+
+static void writeModule(Module &M, StringRef Name) {
+  WriteModule(M, Name.str());
+}
+
+static std::string getOutputPath(StringRef Name) {
+  SmallString<128> Path(OutputDir.getValue());
+  sys::path::append(Path, Name);
+  return std::string(Path);
+}
+
+// Mutate a copy of M and return every decision made, replaying Replay if it
+// is given. The result replays exactly, without diverging.
+static Tracer::Trace recordTrace(const Module &M,
+                                 const MissedOptConfig &Config,
+                                 const Tracer::Trace *Replay) {
+  auto Mutated = CloneModule(M);
+  InstallSeed(Config.Seed);
+  if (Replay)
+    Tracer::get()->startReplaying(*Replay, /*IdleAfterDivergence=*/true);
+  Tracer::get()->startRecording("");
+
+  Mutator Mut(0, "", "");
+  Mut.setPipeline(Config.Pipeline);
+  Mut.mutate(*Mutated);
+
+  Tracer::Trace Recorded = Tracer::get()->getRecorded();
+  Tracer::get()->stop();
+  return Recorded;
+}
+
+static bool isTaken(const Tracer::Trace &T, const Tracer::Decision &D) {
+  const auto &Idle = T.Sites[D.Site].Idle;
+  return Idle && D.Value != *Idle;
+}
+
+// Force the taken decisions that are not kept to their idle value.
+static Tracer::Trace makeCandidate(const Tracer::Trace &T,
+                                   ArrayRef<unsigned> Taken,
+                                   ArrayRef<DeltaDebugger::Chunk> Kept) {
+  Tracer::Trace Candidate = T;
+  for (unsigned I = 0; I < Taken.size(); ++I)
+    if (!DeltaDebugger::isKept(Kept, I)) {
+      auto &D = Candidate.Decisions[Taken[I]];
+      D.Value = *Candidate.Sites[D.Site].Idle;
+    }
+  return Candidate;
+}
+
+static void printSummary(const Tracer::Trace &T,
+                         const std::vector<std::string> &Pipeline,
+                         raw_ostream &OS) {
+  MapVector<std::pair<uint32_t, uint32_t>, unsigned> Counts;
+  for (const auto &D : T.Decisions)
+    if (isTaken(T, D))
+      ++Counts[{D.PassIndex, D.Site}];
+
+  for (auto &[Key, Count] : Counts) {
+    auto [PassIndex, Site] = Key;
+    OS << Count << " x " << T.Sites[Site].Description << " in pass "
+       << PassIndex;
+    if (PassIndex < Pipeline.size())
+      OS << " (" << Pipeline[PassIndex] << ")";
+    OS << "\n";
+  }
+}
+
+int main(int Argc, char **Argv) {
+  cl::HideUnrelatedOptions({&MOMinimizeOptions, &getColorCategory()});
+  cl::ParseCommandLineOptions(Argc, Argv);
+
+  LLVMContext Context;
+  std::unique_ptr<Module> Original = readModule(Context, InputFilename);
+  if (!Original)
+    return 1;
+
+  MissedOptConfig Config;
+  Config.FuncName = FuncName;
+  Config.Seed = ReadSeed(SeedFile);
+  Config.Pipeline = ReadPipeline(PipelineFile);
+  Config.OriginalOpt = OriginalOpt;
+  Config.MutantOpt = MutantOpt;
+
+  Tracer::Trace Full;
+  if (TraceFile.empty())
+    Full = recordTrace(*Original, Config, nullptr);
+  else if (auto T = Tracer::read(TraceFile))
+    Full = *T;
+  else {
+    errs() << "Broken trace: " << TraceFile << "\n";
+    return 1;
+  }
+
+  MissedOptOracle Oracle(Config);
+  if (!Oracle.init(*Original, &Full)) {
+    errs() << "Not interesting: " << InputFilename << "\n";
+    return 1;
+  }
+
+  std::vector<unsigned> Taken;
+  for (unsigned I = 0; I < Full.Decisions.size(); ++I)
+    if (isTaken(Full, Full.Decisions[I]))
+      Taken.push_back(I);
+
+  std::string Bitcode;
+  raw_string_ostream OS(Bitcode);
+  WriteBitcodeToFile(*Original, OS);
+  OS.flush();
+
+  VerdictCache Cache;
+  auto Test = [&](ArrayRef<DeltaDebugger::Chunk> Kept,
+                  const std::function<bool()> &Cancelled) {
+    Tracer::Trace Candidate = makeCandidate(Full, Taken, Kept);
+
+    std::vector<uint32_t> Values;
+    for (unsigned I : Taken)
+      Values.push_back(Candidate.Decisions[I].Value);
+    uint64_t Hash = xxHash64(ArrayRef<uint8_t>(
+        reinterpret_cast<const uint8_t *>(Values.data()),
+        Values.size() * sizeof(uint32_t)));
+    if (auto Verdict = Cache.lookup(Hash))
+      return *Verdict;
+
+    // LLVMContext is not thread-safe, every candidate owns one.
+    LLVMContext CandidateContext;
+    auto Buffer = MemoryBuffer::getMemBuffer(Bitcode, "", false);
+    auto M = parseBitcodeFile(Buffer->getMemBufferRef(), CandidateContext);
+    if (!M) {
+      consumeError(M.takeError());
+      return false;
+    }
+
+    bool Interesting = Oracle.isInteresting(**M, Cancelled, &Candidate);
+    if (!Cancelled())
+      Cache.insert(Hash, Interesting);
+    return Interesting;
+  };
+
+  unsigned NumJobs =
+      Jobs ? Jobs.getValue() : hardware_concurrency().compute_thread_count();
+  auto Kept = DeltaDebugger(Test, NumJobs).run(Taken.size());
+  Tracer::Trace Minimized = makeCandidate(Full, Taken, Kept);
+
+  MODEBUG(dbgs() << "[mominimize] Cache hits: " << Cache.getHits()
+                 << ", misses: " << Cache.getMisses() << "\n");
+
+  // Record the minimized mutant again, so that `unoptgen -replay` reproduces
+  // it without diverging.
+  Tracer::Trace Exact = recordTrace(*Original, Config, &Minimized);
+  auto Result = Oracle.check(*Original, [] { return false; }, &Exact);
+
+  sys::fs::create_directories(OutputDir);
+  if (!Tracer::write(getOutputPath("trace"), Exact)) {
+    errs() << "Cannot write " << getOutputPath("trace") << "\n";
+    return 1;
+  }
+  if (Result.Mutated)
+    writeModule(*Result.Mutated, getOutputPath("mutated.ll"));
+  if (Result.OriginalOpt)
+    writeModule(*Result.OriginalOpt, getOutputPath("original_opt.ll"));
+  if (Result.MutatedOpt)
+    writeModule(*Result.MutatedOpt, getOutputPath("mutated_opt.ll"));
+
+  unsigned NumKept = 0;
+  for (auto C : Kept)
+    NumKept += C.size();
+  outs() << "Kept " << NumKept << " of " << Taken.size()
+         << " taken decisions:\n";
+  printSummary(Minimized, Config.Pipeline, outs());
+  return 0;
+}
@@ -0,0 +1,103 @@
+#include "MissedOptOracle.h"
+#include "engine/Mutator.h"
+#include "engine/Optimizer.h"
+#include "indicators/DiffChecker.h"
+#include "indicators/InlineIndicator.h"
+#include "indicators/InstCountIndicator.h"
+#include "indicators/StaticProfileIndicator.h"
+#include "indicators/UBChecker.h"
+#include "tools/mo-diff/lib/InstFeature.h"
+#include "utils/Random.h"
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <sstream>
+
+using namespace llvm;
+
+static Function *getDefinedFunction(Module &M, StringRef Name) {
+  Function *F = M.getFunction(Name);
+  if (!F || F->isDeclaration())
+    return nullptr;
+  return F;
+}
+
+MissedOptOracle::Result
+MissedOptOracle::run(const Module &Original,
+                     const std::function<bool()> &Cancelled,
+                     const Tracer::Trace *Replay, std::string &CurSignature) {
+  Result Ret;
+  Ret.Mutated = CloneModule(Original);
+  Ret.OriginalOpt = CloneModule(Original);
+
+  Function *OriginalF = getDefinedFunction(*Ret.OriginalOpt, Config.FuncName);
+  if (!OriginalF)
+    return Ret;
+
+  // Mutate with the recorded seed and pipeline.
+  InstallSeed(Config.Seed);
+  if (Replay)
+    Tracer::get()->startReplaying(*Replay, /*IdleAfterDivergence=*/true);
+  Mutator M(0, "", "");
+  M.setPipeline(Config.Pipeline);
+  int Error = M.mutate(*Ret.Mutated);
+  if (Replay)
+    Tracer::get()->stop();
+  if (Error || Cancelled())
+    return Ret;
+
+  Function *MutatedF = getDefinedFunction(*Ret.Mutated, Config.FuncName);
+  if (!MutatedF)
+    return Ret;
+
+  // Check UB in unoptimized pair
+  if (UBChecker().worth(*MutatedF, *OriginalF) <= 0)
+    return Ret;
+
+  Ret.MutatedOpt = CloneModule(*Ret.Mutated);
+  if (Optimizer(Config.OriginalOpt).run(*Ret.OriginalOpt) != 0 || Cancelled())
+    return Ret;
+  if (Optimizer(Config.MutantOpt).run(*Ret.MutatedOpt) != 0 || Cancelled())
+    return Ret;
+
+  OriginalF = getDefinedFunction(*Ret.OriginalOpt, Config.FuncName);
+  MutatedF = getDefinedFunction(*Ret.MutatedOpt, Config.FuncName);
+  if (!OriginalF || !MutatedF)
+    return Ret;
+
+  std::ostringstream Diff;
+  InstFeature().PutDiff(*OriginalF, *MutatedF, Diff);
+  CurSignature = Diff.str();
+  if (Signature && CurSignature != *Signature)
+    return Ret;
+
+  std::vector<std::shared_ptr<Indicator>> Indicators = {
+      std::make_shared<InstCountIndicator>(),
+      std::make_shared<UBChecker>(),
+      std::make_shared<InlineIndicator>(),
+      std::make_shared<StaticProfileIndicator>(),
+      std::make_shared<DiffChecker>(),
+  };
+  Ret.Interesting = std::all_of(
+      Indicators.begin(), Indicators.end(),
+      [&](std::shared_ptr<Indicator> I) {
+        return I->worth(*MutatedF, *OriginalF) > 0;
+      });
+  return Ret;
+}
+
+bool MissedOptOracle::init(const Module &Original,
+                           const Tracer::Trace *Replay) {
+  Signature.reset();
+  std::string Reference;
+  if (!run(Original, [] { return false; }, Replay, Reference).Interesting)
+    return false;
+  Signature = Reference;
+  return true;
+}
+
+MissedOptOracle::Result
+MissedOptOracle::check(const Module &Original,
+                       const std::function<bool()> &Cancelled,
+                       const Tracer::Trace *Replay) {
+  std::string CurSignature;
+  return run(Original, Cancelled, Replay, CurSignature);
+}
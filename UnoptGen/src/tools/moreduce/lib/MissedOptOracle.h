@@ -0,0 +1,65 @@
+#pragma once
+
+#include "trace/Tracer.h"
+#include <functional>
+#include <llvm/IR/Module.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+/*
+ * In-process replay of scripts/reduce_oracle.py: mutate the candidate with the
+ * recorded seed and pipeline, check that the pair is free of obvious UB,
+ * optimize both sides and check that the same missed optimization remains.
+ */
+
+struct MissedOptConfig {
+  std::string FuncName;
+  ulong Seed;
+  std::vector<std::string> Pipeline;
+  // Options as passed to opt, like "-O3".
+  std::string OriginalOpt = "-O3";
+  std::string MutantOpt = "-O3";
+};
+
+class MissedOptOracle {
+public:
+  struct Result {
+    bool Interesting = false;
+    std::unique_ptr<Module> Mutated;
+    std::unique_ptr<Module> OriginalOpt;
+    std::unique_ptr<Module> MutatedOpt;
+  };
+
+  MissedOptOracle(const MissedOptConfig &Config) : Config(Config) {}
+
+  // Record the diff signature of the unreduced pair. Return false if the input
+  // is not interesting at all.
+  bool init(const Module &Original, const Tracer::Trace *Replay = nullptr);
+
+  // Check the candidate. Give up as soon as Cancelled() turns true. If Replay
+  // is given, the mutator replays its decisions instead of drawing them from
+  // the seed, and gates not covered by it leave the code alone.
+  Result check(const Module &Original, const std::function<bool()> &Cancelled,
+               const Tracer::Trace *Replay = nullptr);
+
+  bool isInteresting(const Module &Original,
+                     const std::function<bool()> &Cancelled,
+                     const Tracer::Trace *Replay = nullptr) {
+    return check(Original, Cancelled, Replay).Interesting;
+  }
+
+  const MissedOptConfig &getConfig() const { return Config; }
+
+private:
+  Result run(const Module &Original, const std::function<bool()> &Cancelled,
+             const Tracer::Trace *Replay, std::string &Signature);
+
+  MissedOptConfig Config;
+  std::optional<std::string> Signature;
+};
+
+} // namespace llvm
@@ -0,0 +1,210 @@
+#include "ParallelReducer.h"
+#include "DiffEngine.h"
+#include "utils/Debug.h"
+#include "utils/Hash.h"
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <variant>
+
+using namespace llvm;
+
+typedef std::variant<Function *, Instruction *> ReduceItem;
+
+static bool isRemovable(const Instruction &I) {
+  return !I.isTerminator() && !I.isEHPad() && !I.getType()->isTokenTy();
+}
+
+// Enumerate the items in a fixed order, so that an index means the same item
+// in every materialized copy of the module.
+static std::vector<ReduceItem> collectItems(Module &M, StringRef FuncName) {
+  std::vector<ReduceItem> Items;
+  for (Function &F : M)
+    if (!F.isDeclaration() && F.getName() != FuncName)
+      Items.push_back(&F);
+
+  if (Function *F = M.getFunction(FuncName))
+    for (BasicBlock &BB : *F)
+      for (Instruction &I : BB)
+        if (isRemovable(I))
+          Items.push_back(&I);
+
+  return Items;
+}
+
+static void removeItem(ReduceItem Item) {
+  if (auto *F = std::get_if<Function *>(&Item)) {
+    (*F)->deleteBody();
+    return;
+  }
+
+  Instruction *I = std::get<Instruction *>(Item);
+  if (!I->getType()->isVoidTy())
+    I->replaceAllUsesWith(Constant::getNullValue(I->getType()));
+  I->eraseFromParent();
+}
+
+std::unique_ptr<Module>
+ParallelReducer::materialize(ArrayRef<DeltaDebugger::Chunk> Kept,
+                             LLVMContext &Context) {
+  auto Buffer = MemoryBuffer::getMemBuffer(Bitcode, "", false);
+  auto M = parseBitcodeFile(Buffer->getMemBufferRef(), Context);
+  if (!M) {
+    consumeError(M.takeError());
+    return nullptr;
+  }
+
+  std::vector<ReduceItem> Items =
+      collectItems(**M, Oracle.getConfig().FuncName);
+  for (unsigned Pos = 0; Pos < Items.size() && Pos < FirstPinned; ++Pos)
+    if (!DeltaDebugger::isKept(Kept, Pos))
+      removeItem(Items[Order.empty() ? Pos : Order[Pos]]);
+
+  if (verifyModule(**M))
+    return nullptr;
+  return std::move(*M);
+}
+
+bool ParallelReducer::test(ArrayRef<DeltaDebugger::Chunk> Kept,
+                           const std::function<bool()> &Cancelled) {
+  // LLVMContext is not thread-safe, every candidate owns one.
+  LLVMContext Context;
+  auto M = materialize(Kept, Context);
+  if (!M)
+    return false;
+
+  uint64_t Hash = hashModule(*M);
+  if (auto Verdict = Cache.lookup(Hash))
+    return *Verdict;
+
+  bool Interesting = Oracle.isInteresting(*M, Cancelled);
+  // The oracle bails out early when cancelled, so its verdict is unreliable.
+  if (!Cancelled())
+    Cache.insert(Hash, Interesting);
+  return Interesting;
+}
+
+// Names of the instructions and blocks of F that DiffEngine left unmatched.
+static void collectUnmatchedNames(DiffEngine &Engine, const Function &F,
+                                  StringSet<> &Names) {
+  for (const BasicBlock &BB : F) {
+    if (BB.hasName() && !Engine.Blocks.contains(&BB))
+      Names.insert(BB.getName());
+    for (const Instruction &I : BB)
+      if (I.hasName() && !Engine.Values.contains(&I))
+        Names.insert(I.getName());
+  }
+}
+
+unsigned ParallelReducer::orderByDiff(Module &M) {
+  std::vector<ReduceItem> Items =
+      collectItems(M, Oracle.getConfig().FuncName);
+  Function *F = M.getFunction(Oracle.getConfig().FuncName);
+  auto Result = Oracle.check(M, [] { return false; });
+  if (!F || !Result.Mutated || !Result.OriginalOpt || !Result.MutatedOpt)
+    return Items.size();
+
+  // Instructions of the original that the mutator touched.
+  DiffEngine MutationDiff;
+  MutationDiff.diff(&M, Result.Mutated.get());
+
+  // The optimizer rewrites the code, so the differing region of the optimized
+  // pair can only be mapped back through the names it kept. This only decides
+  // the sweep order, the oracle still has the final word.
+  DiffEngine OptDiff;
+  OptDiff.diff(Result.OriginalOpt.get(), Result.MutatedOpt.get());
+  StringSet<> Unmatched;
+  if (Function *OptF = Result.OriginalOpt->getFunction(F->getName()))
+    collectUnmatchedNames(OptDiff, *OptF, Unmatched);
+
+  auto IsDiffering = [&](ReduceItem Item) {
+    auto *I = std::get_if<Instruction *>(&Item);
+    if (!I)
+      return false;
+    return !MutationDiff.Values.contains(*I) ||
+           ((*I)->hasName() && Unmatched.contains((*I)->getName())) ||
+           ((*I)->getParent()->hasName() &&
+            Unmatched.contains((*I)->getParent()->getName()));
+  };
+
+  Order.clear();
+  for (unsigned I = 0; I < Items.size(); ++I)
+    if (!IsDiffering(Items[I]))
+      Order.push_back(I);
+  unsigned NumMatched = Order.size();
+  for (unsigned I = 0; I < Items.size(); ++I)
+    if (IsDiffering(Items[I]))
+      Order.push_back(I);
+  return NumMatched;
+}
+
+std::unique_ptr<Module> ParallelReducer::reduce(const Module &M,
+                                                LLVMContext &Context) {
+  if (!Oracle.init(M))
+    return nullptr;
+
+  Bitcode.clear();
+  raw_string_ostream OS(Bitcode);
+  WriteBitcodeToFile(M, OS);
+  OS.flush();
+
+  DeltaDebugger DD(
+      [this](ArrayRef<DeltaDebugger::Chunk> Kept,
+             const std::function<bool()> &Cancelled) {
+        return test(Kept, Cancelled);
+      },
+      Jobs);
+
+  // Sweep the matched items first, with the differing region pinned.
+  std::unique_ptr<Module> Reduced;
+  {
+    LLVMContext RoundContext;
+    Order.clear();
+    FirstPinned = ~0u;
+    auto Base = materialize({{0, ~0u}}, RoundContext);
+    FirstPinned = orderByDiff(*Base);
+
+    auto Kept = DD.run(FirstPinned);
+    MODEBUG(dbgs() << "[moreduce] Diff-guided round: " << FirstPinned
+                   << " matched items, cache hits: " << Cache.getHits()
+                   << ", misses: " << Cache.getMisses() << "\n");
+
+    Reduced = materialize(Kept, Context);
+    Order.clear();
+    FirstPinned = ~0u;
+    Bitcode.clear();
+    WriteBitcodeToFile(*Reduced, OS);
+    OS.flush();
+  }
+
+  // Removing items may make others removable, so repeat until a round reduces
+  // nothing.
+  while (true) {
+    LLVMContext RoundContext;
+    auto Base = materialize({{0, ~0u}}, RoundContext);
+    unsigned NumItems =
+        collectItems(*Base, Oracle.getConfig().FuncName).size();
+
+    auto Kept = DD.run(NumItems);
+    unsigned NumKept = 0;
+    for (auto C : Kept)
+      NumKept += C.size();
+
+    MODEBUG(dbgs() << "[moreduce] Kept " << NumKept << " of " << NumItems
+                   << " items, cache hits: " << Cache.getHits()
+                   << ", misses: " << Cache.getMisses() << "\n");
+
+    Reduced = materialize(Kept, Context);
+    if (NumKept == NumItems)
+      break;
+
+    Bitcode.clear();
+    WriteBitcodeToFile(*Reduced, OS);
+    OS.flush();
+  }
+
+  return Reduced;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "MissedOptOracle.h"
+#include "engine/DeltaDebugger.h"
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <memory>
+#include <string>
+
+namespace llvm {
+
+/*
+ * In-process replacement of `llvm-reduce --test=reduce_driver.sh`.
+ *
+ * The reducible items are the bodies of the other functions and the
+ * instructions of the target function. Every candidate is materialized in its
+ * own LLVMContext from the bitcode of the input, so that several of them can
+ * be checked by the oracle concurrently. Verdicts are memoized by the
+ * structural hash of the candidate.
+ *
+ * The first round is guided by DiffEngine: the items matched on both sides of
+ * the mutated and optimized pairs are swept before the differing region is
+ * touched at all, since they are the likely removable ones.
+ */
+
+class ParallelReducer {
+public:
+  ParallelReducer(MissedOptOracle &Oracle, unsigned Jobs)
+      : Oracle(Oracle), Jobs(Jobs) {}
+
+  // Reduce M and return the reduced module in Context. Return nullptr if M is
+  // not interesting at all.
+  std::unique_ptr<Module> reduce(const Module &M, LLVMContext &Context);
+
+private:
+  std::unique_ptr<Module> materialize(ArrayRef<DeltaDebugger::Chunk> Kept,
+                                      LLVMContext &Context);
+  bool test(ArrayRef<DeltaDebugger::Chunk> Kept,
+            const std::function<bool()> &Cancelled);
+  // Sort the items of M so that the matched ones come first. Return the
+  // number of matched items.
+  unsigned orderByDiff(Module &M);
+
+  MissedOptOracle &Oracle;
+  unsigned Jobs;
+  VerdictCache Cache;
+  // Bitcode of the module being reduced in the current round.
+  std::string Bitcode;
+  // Item indices in sweep order. Empty for the natural order.
+  std::vector<unsigned> Order;
+  // Items from this position on are kept whatever the sweep decides.
+  unsigned FirstPinned = ~0u;
+};
+
+} // namespace llvm
@@ -1,18 +1,85 @@
 #include "Reducer.h"
-#include <format>
-
-bool llvm::reduceOnCriterion(Module &M, std::string InputFilename,
-                             std::string OutputBitcode,
-                             std::string OutputFilename,
-                             std::string criterion) {
-  auto Command =
-      std::format("llvm-slicer -c {} -entry {} -forward "
-                  "-criteria-are-next-instr {} -o {} &&"
-                  "llvm-dis {} -o {}",
-                  /*slicing criterion*/ criterion,
-                  /*function to slice*/
-                  M.getFunctionList().begin()->getName().str(), InputFilename,
-                  OutputBitcode, OutputBitcode, OutputFilename);
-  int Ret = system(Command.c_str());
-  return Ret == 0;
+#include "Instrumentation.h"
+#include <llvm/ADT/MapVector.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Analysis/AliasAnalysis.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Passes/PassBuilder.h>
+
+using namespace llvm;
+
+bool llvm::reduceOnCriteria(Module &M, ArrayRef<Instruction *> Criteria,
+                            SliceDirection Direction) {
+  MapVector<Function *, SmallVector<Instruction *, 8>> CriteriaOf;
+  for (Instruction *I : Criteria)
+    CriteriaOf[I->getFunction()].push_back(I);
+
+  LoopAnalysisManager LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager CGAM;
+  ModuleAnalysisManager MAM;
+
+  // The default AA pipeline of MemorySSA asks for the module proxy.
+  PassBuilder PB;
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  bool Changed = false;
+  for (auto &[F, FuncCriteria] : CriteriaOf) {
+    auto &MSSA = FAM.getResult<MemorySSAAnalysis>(*F).getMSSA();
+    auto &PDT = FAM.getResult<PostDominatorTreeAnalysis>(*F);
+
+    Slicer S(*F, MSSA, PDT);
+    for (Instruction *Criterion : FuncCriteria) {
+      if (Direction != SliceDirection::Forward)
+        S.sliceBackward(Criterion);
+      if (Direction != SliceDirection::Backward)
+        S.sliceForward(Criterion);
+    }
+
+    FAM.clear(*F, F->getName());
+    Changed |= S.dropOthers();
+  }
+  return Changed;
+}
+
+bool llvm::reduceOnCriterion(Module &M, ArrayRef<std::string> Markers,
+                             SliceDirection Direction) {
+  StringSet<> Wanted;
+  for (auto &Marker : Markers)
+    Wanted.insert(Marker);
+
+  SmallVector<CallInst *, 16> MarkerCalls;
+  SmallVector<Instruction *, 16> Criteria;
+  for (Function &F : M) {
+    if (!F.getName().starts_with(Signature))
+      continue;
+    if (!Wanted.empty() && !Wanted.contains(F.getName()))
+      continue;
+
+    for (User *U : F.users()) {
+      auto *Call = dyn_cast<CallInst>(U);
+      if (!Call)
+        continue;
+      MarkerCalls.push_back(Call);
+      // Markers are inserted right before the instructions they mark.
+      if (Instruction *Next = Call->getNextNode())
+        Criteria.push_back(Next);
+    }
+  }
+
+  for (CallInst *Call : MarkerCalls)
+    Call->eraseFromParent();
+
+  bool Changed = reduceOnCriteria(M, Criteria, Direction);
+
+  for (Function &F : make_early_inc_range(M))
+    if (F.getName().starts_with(Signature) && F.use_empty())
+      F.eraseFromParent();
+
+  return Changed || !MarkerCalls.empty();
 }
@@ -1,11 +1,20 @@
 #pragma once
 
+#include "Slicer.h"
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/IR/Module.h>
 
 namespace llvm {
 
-bool reduceOnCriterion(Module &M, std::string InputFilename,
-                       std::string OutputBitcode, std::string OutputFilename,
-                       std::string criterion);
+// Slice M in memory on the criteria and drop everything else. Return true if
+// M is changed.
+bool reduceOnCriteria(Module &M, ArrayRef<Instruction *> Criteria,
+                      SliceDirection Direction = SliceDirection::Both);
 
-}
+// Slice M on the instructions marked by the given optreduce_use_* markers (all
+// of them if Markers is empty), like `llvm-slicer -criteria-are-next-instr`.
+// The markers are removed afterwards.
+bool reduceOnCriterion(Module &M, ArrayRef<std::string> Markers,
+                       SliceDirection Direction = SliceDirection::Both);
+
+} // namespace llvm
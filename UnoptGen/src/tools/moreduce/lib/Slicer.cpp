@@ -0,0 +1,136 @@
+#include "Slicer.h"
+#include <llvm/IR/CFG.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Instructions.h>
+
+using namespace llvm;
+
+Slicer::Slicer(Function &F, MemorySSA &MSSA, PostDominatorTree &PDT)
+    : F(F), MSSA(MSSA) {
+  // B is control dependent on A if some successor of A reaches B on the
+  // post-dominator tree before the immediate post-dominator of A does.
+  for (BasicBlock &A : F) {
+    DomTreeNode *ANode = PDT.getNode(&A);
+    if (!ANode)
+      continue;
+    DomTreeNode *Stop = ANode->getIDom();
+
+    for (BasicBlock *S : successors(&A)) {
+      if (PDT.dominates(S, &A))
+        continue;
+      for (DomTreeNode *N = PDT.getNode(S); N && N != Stop; N = N->getIDom())
+        if (BasicBlock *BB = N->getBlock()) {
+          ControlDeps[BB].insert(&A);
+          Dependents[&A].insert(BB);
+        }
+    }
+  }
+}
+
+void Slicer::addMemoryDefs(MemoryAccess *MA,
+                           SmallVectorImpl<Instruction *> &Deps) {
+  if (!MA || MSSA.isLiveOnEntryDef(MA) || !VisitedAccesses.insert(MA).second)
+    return;
+
+  if (auto *Def = dyn_cast<MemoryDef>(MA)) {
+    Deps.push_back(Def->getMemoryInst());
+    return;
+  }
+
+  for (Value *Incoming : cast<MemoryPhi>(MA)->incoming_values())
+    addMemoryDefs(cast<MemoryAccess>(Incoming), Deps);
+}
+
+void Slicer::addMemoryUsers(MemoryAccess *MA,
+                            SmallVectorImpl<Instruction *> &Deps) {
+  for (User *U : MA->users()) {
+    if (auto *UseOrDef = dyn_cast<MemoryUseOrDef>(U))
+      Deps.push_back(UseOrDef->getMemoryInst());
+    else if (auto *Phi = dyn_cast<MemoryPhi>(U))
+      if (VisitedAccesses.insert(Phi).second)
+        addMemoryUsers(Phi, Deps);
+  }
+}
+
+void Slicer::sliceBackward(Instruction *Criterion) {
+  SmallVector<Instruction *, 32> Worklist = {Criterion};
+  SmallPtrSet<const Instruction *, 32> Visited;
+  VisitedAccesses.clear();
+
+  while (!Worklist.empty()) {
+    Instruction *I = Worklist.pop_back_val();
+    if (!Visited.insert(I).second)
+      continue;
+    Slice.insert(I);
+
+    // Data dependence
+    for (Value *Op : I->operands())
+      if (auto *OpI = dyn_cast<Instruction>(Op))
+        Worklist.push_back(OpI);
+
+    // Memory dependence
+    if (auto *MA = MSSA.getMemoryAccess(I)) {
+      if (isa<MemoryUse>(MA))
+        addMemoryDefs(MSSA.getWalker()->getClobberingMemoryAccess(I),
+                      Worklist);
+      else
+        addMemoryDefs(cast<MemoryUseOrDef>(MA)->getDefiningAccess(),
+                      Worklist);
+    }
+
+    // Control dependence, including the choice of incoming values of phis.
+    for (BasicBlock *Controller : ControlDeps.lookup(I->getParent()))
+      Worklist.push_back(Controller->getTerminator());
+    if (auto *PN = dyn_cast<PHINode>(I))
+      for (BasicBlock *Incoming : PN->blocks())
+        Worklist.push_back(Incoming->getTerminator());
+  }
+}
+
+void Slicer::sliceForward(Instruction *Criterion) {
+  SmallVector<Instruction *, 32> Worklist = {Criterion};
+  SmallPtrSet<const Instruction *, 32> Visited;
+  VisitedAccesses.clear();
+
+  while (!Worklist.empty()) {
+    Instruction *I = Worklist.pop_back_val();
+    if (!Visited.insert(I).second)
+      continue;
+    Slice.insert(I);
+
+    // Data dependence
+    for (User *U : I->users())
+      if (auto *UI = dyn_cast<Instruction>(U))
+        Worklist.push_back(UI);
+
+    // Memory dependence
+    if (auto *Def = dyn_cast_or_null<MemoryDef>(MSSA.getMemoryAccess(I)))
+      addMemoryUsers(Def, Worklist);
+
+    // Control dependence
+    if (I->isTerminator()) {
+      BasicBlock *BB = I->getParent();
+      for (BasicBlock *Dependent : Dependents.lookup(BB))
+        for (Instruction &DI : *Dependent)
+          Worklist.push_back(&DI);
+      for (BasicBlock *Succ : successors(BB))
+        for (PHINode &PN : Succ->phis())
+          Worklist.push_back(&PN);
+    }
+  }
+}
+
+bool Slicer::dropOthers() {
+  SmallVector<Instruction *, 64> Dropped;
+  for (BasicBlock &BB : F)
+    for (Instruction &I : BB)
+      if (!I.isTerminator() && !inSlice(&I))
+        Dropped.push_back(&I);
+
+  for (Instruction *I : Dropped) {
+    if (!I->getType()->isVoidTy())
+      I->replaceAllUsesWith(Constant::getNullValue(I->getType()));
+    I->eraseFromParent();
+  }
+  return !Dropped.empty();
+}
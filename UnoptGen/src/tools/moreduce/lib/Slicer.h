@@ -0,0 +1,47 @@
+#pragma once
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SetVector.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/Analysis/MemorySSA.h>
+#include <llvm/Analysis/PostDominators.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instruction.h>
+
+namespace llvm {
+
+enum class SliceDirection { Backward, Forward, Both };
+
+/*
+ * Program slicer over SSA def-use chains, MemorySSA and control dependence.
+ * The backward slice of a criterion contains everything it depends on, and
+ * the forward slice contains everything depending on it.
+ */
+
+class Slicer {
+public:
+  Slicer(Function &F, MemorySSA &MSSA, PostDominatorTree &PDT);
+
+  void sliceBackward(Instruction *Criterion);
+  void sliceForward(Instruction *Criterion);
+
+  bool inSlice(const Instruction *I) const { return Slice.contains(I); }
+
+  // Remove every non-terminator out of the slice. Return true if changed.
+  bool dropOthers();
+
+private:
+  void addMemoryDefs(MemoryAccess *MA, SmallVectorImpl<Instruction *> &Deps);
+  void addMemoryUsers(MemoryAccess *MA, SmallVectorImpl<Instruction *> &Deps);
+
+  Function &F;
+  MemorySSA &MSSA;
+  // Blocks and the blocks whose terminators decide whether they execute.
+  DenseMap<const BasicBlock *, SmallSetVector<BasicBlock *, 4>> ControlDeps;
+  // The inverse of ControlDeps.
+  DenseMap<const BasicBlock *, SmallSetVector<BasicBlock *, 4>> Dependents;
+  SmallPtrSet<const Instruction *, 32> Slice;
+  SmallPtrSet<const MemoryAccess *, 16> VisitedAccesses;
+};
+
+} // namespace llvm
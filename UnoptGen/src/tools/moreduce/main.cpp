@@ -1,7 +1,10 @@
 #include "lib/Canonicalizer.h"
 #include "lib/DiffEngine.h"
 #include "lib/Instrumentation.h"
+#include "lib/MissedOptOracle.h"
+#include "lib/ParallelReducer.h"
 #include "lib/Reducer.h"
+#include "utils/Files.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/WithColor.h"
@@ -11,6 +14,9 @@
 #include <llvm/IR/Module.h>
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Threading.h>
 
 using namespace llvm;
 
@@ -21,18 +27,43 @@ static cl::opt<std::string> LeftFilename(cl::Positional,
                                          cl::cat(MOReducerOptions));
 static cl::opt<std::string> RightFilename(cl::Positional,
                                           cl::desc("<second file>"),
-                                          cl::Required,
                                           cl::cat(MOReducerOptions));
 static cl::opt<bool> DoInstrumentation("i", cl::desc("Do instrumentation"),
                                        cl::cat(MOReducerOptions));
 
-static cl::opt<bool> UseSlicer("s", cl::desc("Use slicer"),
+static cl::opt<bool> UseSlicer("s", cl::desc("Slice both files on their differences"),
                                cl::cat(MOReducerOptions));
 
+static cl::opt<bool>
+    DoReduce("reduce",
+             cl::desc("Reduce the first file in-process, keeping the missed "
+                      "optimization of its mutant"),
+             cl::cat(MOReducerOptions));
+static cl::opt<std::string> FuncName("func", cl::desc("<function name>"),
+                                     cl::cat(MOReducerOptions));
+static cl::opt<std::string> SeedFile("seed", cl::desc("Seed file"),
+                                     cl::cat(MOReducerOptions));
+static cl::opt<std::string> PipelineFile("pipeline",
+                                         cl::desc("File of pipeline list"),
+                                         cl::cat(MOReducerOptions));
+static cl::opt<std::string>
+    OriginalOpt("original-opt", cl::desc("opt option for the original"),
+                cl::init("-O3"), cl::cat(MOReducerOptions));
+static cl::opt<std::string>
+    MutantOpt("mutant-opt", cl::desc("opt option for the mutant"),
+              cl::init("-O3"), cl::cat(MOReducerOptions));
+static cl::opt<unsigned>
+    Jobs("j", cl::desc("Number of candidates to check concurrently"),
+         cl::init(0), cl::cat(MOReducerOptions));
+static cl::opt<std::string> OutputDir("o",
+                                      cl::desc("Directory of reduced files"),
+                                      cl::init("."),
+                                      cl::cat(MOReducerOptions));
+
 static std::unique_ptr<Module> readModule(LLVMContext &Context,
                                           StringRef Name) {
   SMDiagnostic Diag;
-  std::unique_ptr<Module> M = parseIRFile(Name, Diag, Context);
+  std::unique_ptr<Module> M = ParseIRFile(Name.str(), Diag, Context);
   if (!M)
     Diag.print("moreduce", errs());
   return M;
@@ -43,16 +74,71 @@ template <typename T> static std::string joinStringList(T Set) {
 }
 
 static void writeModule(Module &M, StringRef Name) {
-  // TODO: Support bitcode writer
-  std::error_code EC;
-  raw_fd_ostream Out(Name, EC, sys::fs::OF_Text);
-  M.print(Out, nullptr);
+  WriteModule(M, Name.str());
+}
+
+static int reduce() {
+  if (FuncName.empty() || SeedFile.empty() || PipelineFile.empty()) {
+    errs() << "-reduce requires -func, -seed and -pipeline\n";
+    return 1;
+  }
+  if (!sys::fs::exists(SeedFile)) {
+    errs() << "No such seed file: " << SeedFile << "\n";
+    return 1;
+  }
+
+  LLVMContext Context;
+  std::unique_ptr<Module> Original = readModule(Context, LeftFilename);
+  if (!Original)
+    return 1;
+
+  MissedOptConfig Config;
+  Config.FuncName = FuncName;
+  Config.Seed = ReadSeed(SeedFile);
+  Config.Pipeline = ReadPipeline(PipelineFile);
+  Config.OriginalOpt = OriginalOpt;
+  Config.MutantOpt = MutantOpt;
+
+  unsigned NumJobs =
+      Jobs ? Jobs.getValue() : hardware_concurrency().compute_thread_count();
+  MissedOptOracle Oracle(Config);
+  std::unique_ptr<Module> Reduced =
+      ParallelReducer(Oracle, NumJobs).reduce(*Original, Context);
+  if (!Reduced) {
+    errs() << "Not interesting: " << LeftFilename << "\n";
+    return 1;
+  }
+
+  // Keep the same files as reduce_oracle.py does.
+  auto Result = Oracle.check(*Reduced, [] { return false; });
+  sys::fs::create_directories(OutputDir);
+  auto OutputPath = [](StringRef Name) {
+    SmallString<128> Path(OutputDir.getValue());
+    sys::path::append(Path, Name);
+    return std::string(Path);
+  };
+  writeModule(*Reduced, OutputPath("original.ll"));
+  if (Result.Mutated)
+    writeModule(*Result.Mutated, OutputPath("mutated.ll"));
+  if (Result.OriginalOpt)
+    writeModule(*Result.OriginalOpt, OutputPath("original_opt.ll"));
+  if (Result.MutatedOpt)
+    writeModule(*Result.MutatedOpt, OutputPath("mutated_opt.ll"));
+  return 0;
 }
 
 int main(int Argc, char **Argv) {
   cl::HideUnrelatedOptions({&MOReducerOptions, &getColorCategory()});
   cl::ParseCommandLineOptions(Argc, Argv);
 
+  if (DoReduce)
+    return reduce();
+
+  if (RightFilename.empty()) {
+    errs() << "Two files are required unless -reduce is given\n";
+    return 1;
+  }
+
   // Read IR, FIXME: share one context and don't lose type equivalence
   // information
   LLVMContext Context;
@@ -71,10 +157,22 @@ int main(int Argc, char **Argv) {
   writeModule(*LModule, LeftFilename + ".canon.ll");
   writeModule(*RModule, RightFilename + ".canon.ll");
 
-  //auto [LMarkers, RMarkers] = markDiffs(Engine, *LModule, *RModule);
+  if (!DoInstrumentation && !UseSlicer)
+    return 0;
+
+  auto [LMarkers, RMarkers] = markDiffs(Engine, *LModule, *RModule);
+
+  if (UseSlicer) {
+    reduceOnCriterion(*LModule, LMarkers);
+    reduceOnCriterion(*RModule, RMarkers);
+    writeModule(*LModule, LeftFilename + ".sliced.ll");
+    writeModule(*RModule, RightFilename + ".sliced.ll");
+    return 0;
+  }
 
-  //writeModule(*LModule, LeftFilename + ".in.ll");
-  //writeModule(*RModule, RightFilename + ".in.ll");
-  //outs() << joinStringList(LMarkers) << "\n";
-  //outs() << joinStringList(RMarkers) << "\n";
+  writeModule(*LModule, LeftFilename + ".in.ll");
+  writeModule(*RModule, RightFilename + ".in.ll");
+  outs() << joinStringList(LMarkers) << "\n";
+  outs() << joinStringList(RMarkers) << "\n";
+  return 0;
 }
@@ -2,6 +2,7 @@
 #include "llvm/Support/Program.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/WithColor.h"
+#include "utils/Files.h"
 #include <llvm/ADT/StringExtras.h>
 #include <llvm/ADT/iterator_range.h>
 #include <llvm/IR/LLVMContext.h>
@@ -29,7 +30,7 @@ static cl::opt<bool> UseSlicer("s", cl::desc("Use slicer"),
 static std::unique_ptr<Module> readModule(LLVMContext &Context,
                                           StringRef Name) {
   SMDiagnostic Diag;
-  std::unique_ptr<Module> M = parseIRFile(Name, Diag, Context);
+  std::unique_ptr<Module> M = ParseIRFile(Name.str(), Diag, Context);
   if (!M)
     Diag.print("moreduce", errs());
   return M;
@@ -40,10 +41,7 @@ template <typename T> static std::string joinStringList(T Set) {
 }
 
 static void writeModule(Module &M, StringRef Name) {
-  // TODO: Support bitcode writer
-  std::error_code EC;
-  raw_fd_ostream Out(Name, EC, sys::fs::OF_Text);
-  M.print(Out, nullptr);
+  WriteModule(M, Name.str());
 }
 
 int main(int Argc, char **Argv) {
@@ -0,0 +1,117 @@
+#include "engine/CompileTimeOracle.h"
+#include "engine/Optimizer.h"
+#include "utils/Files.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/WithColor.h"
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+using namespace llvm;
+
+/*
+ * Time every pass of the in-process optimization of an original and its
+ * mutant, and tell whether a pass blows up on the mutant. Exits with 0 on a
+ * blowup, so it can serve as the interestingness test of a reduction.
+ */
+
+cl::OptionCategory MOTimeOptions("MOTime Options");
+
+static cl::opt<std::string> OriginalFile(cl::Positional,
+                                         cl::desc("<original file>"),
+                                         cl::Required, cl::cat(MOTimeOptions));
+static cl::opt<std::string> MutantFile(cl::Positional,
+                                       cl::desc("<mutant file>"), cl::Required,
+                                       cl::cat(MOTimeOptions));
+static cl::opt<std::string>
+    OriginalPipeline("original-opt", cl::desc("Optimization of the original"),
+                     cl::init("-O3"), cl::cat(MOTimeOptions));
+static cl::opt<std::string>
+    MutantPipeline("mutant-opt", cl::desc("Optimization of the mutant"),
+                   cl::init("-O3"), cl::cat(MOTimeOptions));
+static cl::opt<unsigned>
+    Repeats("repeat", cl::desc("Runs of each side, the fastest is kept"),
+            cl::init(3), cl::cat(MOTimeOptions));
+static cl::opt<double>
+    Threshold("threshold",
+              cl::desc("Slowdown per instruction of a blowup"),
+              cl::init(8), cl::cat(MOTimeOptions));
+static cl::opt<double>
+    MinSeconds("min-seconds",
+               cl::desc("Seconds a blowup adds to a pass at least"),
+               cl::init(0.2), cl::cat(MOTimeOptions));
+static cl::opt<unsigned> NumPrinted("print",
+                                    cl::desc("Slowest passes to print"),
+                                    cl::init(10), cl::cat(MOTimeOptions));
+
+static std::unique_ptr<Module> readModule(LLVMContext &Context,
+                                          StringRef Name) {
+  SMDiagnostic Diag;
+  std::unique_ptr<Module> M = ParseIRFile(Name.str(), Diag, Context);
+  if (!M)
+    Diag.print("motime", errs());
+  return M;
+}
+
+static bool timePipeline(const Module &M, const std::string &Pipeline,
+                         PassTimings &Timings) {
+  for (unsigned I = 0; I < std::max(1u, Repeats.getValue()); ++I) {
+    std::unique_ptr<Module> Clone = CloneModule(M);
+    PassTimings Run;
+    if (Optimizer(Pipeline).run(*Clone, &Run))
+      return false;
+    if (I == 0)
+      Timings = Run;
+    else
+      Timings.mergeMin(Run);
+  }
+  return true;
+}
+
+int main(int Argc, char **Argv) {
+  cl::HideUnrelatedOptions({&MOTimeOptions, &getColorCategory()});
+  cl::ParseCommandLineOptions(Argc, Argv);
+
+  LLVMContext Context;
+  std::unique_ptr<Module> Original = readModule(Context, OriginalFile);
+  std::unique_ptr<Module> Mutant = readModule(Context, MutantFile);
+  if (!Original || !Mutant)
+    return 2;
+
+  PassTimings OriginalTimings, MutantTimings;
+  if (!timePipeline(*Original, OriginalPipeline, OriginalTimings) ||
+      !timePipeline(*Mutant, MutantPipeline, MutantTimings))
+    return 2;
+
+  outs() << "size " << OriginalTimings.Size << " -> " << MutantTimings.Size
+         << ", total " << format("%.3fs -> %.3fs", OriginalTimings.Total,
+                                 MutantTimings.Total)
+         << "\n";
+
+  // Passes that slowed down the most first
+  std::vector<std::pair<double, std::string>> Deltas;
+  for (const auto &Entry : MutantTimings.Seconds)
+    Deltas.emplace_back(Entry.getValue() -
+                            OriginalTimings.Seconds.lookup(Entry.getKey()),
+                        Entry.getKey().str());
+  llvm::sort(Deltas, std::greater<>());
+  for (unsigned I = 0; I < Deltas.size() && I < NumPrinted; ++I) {
+    const std::string &Pass = Deltas[I].second;
+    outs() << format("%-40s %8.3fs -> %8.3fs\n", Pass.c_str(),
+                     OriginalTimings.Seconds.lookup(Pass),
+                     MutantTimings.Seconds.lookup(Pass));
+  }
+
+  CompileTimeOracle Oracle(Threshold, MinSeconds);
+  auto Blowup = Oracle.check(OriginalTimings, MutantTimings);
+  if (!Blowup)
+    return 1;
+  outs() << "Blowup in " << Blowup->Pass << ": "
+         << format("%.3fs -> %.3fs, %.1fx per instruction\n",
+                   Blowup->OriginalSeconds, Blowup->MutantSeconds,
+                   Blowup->Ratio);
+  return 0;
+}
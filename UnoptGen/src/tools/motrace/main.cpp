@@ -0,0 +1,161 @@
+#include "engine/Optimizer.h"
+#include "engine/PassTrace.h"
+#include "transforms/IRNormalizer/IRNormalizer.h"
+#include "utils/Files.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/WithColor.h"
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+using namespace llvm;
+
+/*
+ * Follow a function through the in-process optimization of an original and
+ * its mutant, hashing its normal form after every pass, and tell where the
+ * two runs part ways: the last pass after which the function is identical on
+ * both sides, and the pass after which they stop getting closer. That is the
+ * canonicalization the mutation defeated.
+ */
+
+cl::OptionCategory MOTraceOptions("MOTrace Options");
+
+static cl::opt<std::string> OriginalFile(cl::Positional,
+                                         cl::desc("<original file>"),
+                                         cl::Required, cl::cat(MOTraceOptions));
+static cl::opt<std::string> MutantFile(cl::Positional,
+                                       cl::desc("<mutant file>"), cl::Required,
+                                       cl::cat(MOTraceOptions));
+static cl::opt<std::string> FuncName("func", cl::desc("Function to follow"),
+                                     cl::Required, cl::cat(MOTraceOptions));
+static cl::opt<std::string>
+    OriginalPipeline("original-opt", cl::desc("Optimization of the original"),
+                     cl::init("-O3"), cl::cat(MOTraceOptions));
+static cl::opt<std::string>
+    MutantPipeline("mutant-opt", cl::desc("Optimization of the mutant"),
+                   cl::init("-O3"), cl::cat(MOTraceOptions));
+static cl::opt<bool> PrintAll("print-all",
+                              cl::desc("Print the snapshots of every pass"),
+                              cl::init(false), cl::cat(MOTraceOptions));
+static cl::opt<std::string>
+    OutputDir("o",
+              cl::desc("Directory to write both sides, normalized, right "
+                       "after they diverge to"),
+              cl::cat(MOTraceOptions));
+
+static std::unique_ptr<Module> readModule(LLVMContext &Context,
+                                          StringRef Name) {
+  SMDiagnostic Diag;
+  std::unique_ptr<Module> M = ParseIRFile(Name.str(), Diag, Context);
+  if (!M)
+    Diag.print("motrace", errs());
+  return M;
+}
+
+static bool trace(const Module &M, const std::string &Pipeline,
+                  PassTrace &Trace) {
+  std::unique_ptr<Module> Clone = CloneModule(M);
+  if (Optimizer(Pipeline).run(*Clone, nullptr, &Trace))
+    return false;
+  if (Trace.Snapshots.empty()) {
+    errs() << "No function " << Trace.FuncName << "\n";
+    return false;
+  }
+  return true;
+}
+
+// Optimize M up to the snapshot S, normalize it and write it to Name.
+static bool writeSnapshot(const Module &M, const std::string &Pipeline,
+                          const PassSnapshot &S, StringRef Name) {
+  std::unique_ptr<Module> Clone = CloneModule(M);
+  Optimizer Opt(Pipeline);
+  Opt.setPassLimit(S.Index);
+  if (Opt.run(*Clone))
+    return false;
+  normalizeModule(*Clone);
+
+  SmallString<128> Path(OutputDir.getValue());
+  sys::path::append(Path, Name);
+  if (!WriteModule(*Clone, std::string(Path))) {
+    errs() << "Cannot write " << Path << "\n";
+    return false;
+  }
+  return true;
+}
+
+static void printPair(StringRef What, unsigned I, const PassTrace &Original,
+                      const PassTrace &Mutant) {
+  const PassSnapshot &L = Original.Snapshots[I], &R = Mutant.Snapshots[I];
+  outs() << What << " " << I << ": " << L.Pass << ", distance "
+         << Divergence::getDistance(L, R) << "\n";
+}
+
+int main(int Argc, char **Argv) {
+  cl::HideUnrelatedOptions({&MOTraceOptions, &getColorCategory()});
+  cl::ParseCommandLineOptions(Argc, Argv);
+
+  LLVMContext Context;
+  std::unique_ptr<Module> Original = readModule(Context, OriginalFile);
+  std::unique_ptr<Module> Mutant = readModule(Context, MutantFile);
+  if (!Original || !Mutant)
+    return 2;
+
+  PassTrace OriginalTrace(FuncName), MutantTrace(FuncName);
+  if (!trace(*Original, OriginalPipeline, OriginalTrace) ||
+      !trace(*Mutant, MutantPipeline, MutantTrace))
+    return 2;
+
+  Divergence D = Divergence::compute(OriginalTrace, MutantTrace);
+  const auto &L = OriginalTrace.Snapshots, &R = MutantTrace.Snapshots;
+
+  if (PrintAll)
+    for (unsigned I = 0; I < std::max(L.size(), R.size()); ++I) {
+      outs() << format("%4u ", I);
+      if (I < L.size())
+        outs() << format_hex_no_prefix(L[I].Hash, 16) << " ";
+      else
+        outs() << "---------------- ";
+      if (I < R.size())
+        outs() << format_hex_no_prefix(R[I].Hash, 16) << " ";
+      else
+        outs() << "---------------- ";
+      outs() << (I < L.size() ? L[I].Pass : R[I].Pass);
+      if (I < D.NumPaired)
+        outs() << " (" << Divergence::getDistance(L[I], R[I]) << ")";
+      outs() << "\n";
+    }
+
+  if (D.LastIdentical)
+    printPair("Last identical after snapshot", *D.LastIdentical,
+              OriginalTrace, MutantTrace);
+  else
+    outs() << "Never identical\n";
+  printPair("Closest after snapshot", D.Closest, OriginalTrace, MutantTrace);
+
+  unsigned Diverge = D.Closest + 1;
+  if (Diverge < D.NumPaired)
+    printPair("Stops converging at snapshot", Diverge, OriginalTrace,
+              MutantTrace);
+  if (D.NumPaired < L.size() || D.NumPaired < R.size()) {
+    outs() << "Passes differ from snapshot " << D.NumPaired << ": "
+           << (D.NumPaired < L.size() ? L[D.NumPaired].Pass : "end") << " / "
+           << (D.NumPaired < R.size() ? R[D.NumPaired].Pass : "end") << "\n";
+  }
+
+  if (!OutputDir.empty() && Diverge < D.NumPaired) {
+    if (sys::fs::create_directories(OutputDir)) {
+      errs() << "Cannot create " << OutputDir << "\n";
+      return 2;
+    }
+    if (!writeSnapshot(*Original, OriginalPipeline, L[Diverge],
+                       "original.ll") ||
+        !writeSnapshot(*Mutant, MutantPipeline, R[Diverge], "mutant.ll"))
+      return 2;
+  }
+  return 0;
+}
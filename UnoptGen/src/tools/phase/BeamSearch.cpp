@@ -0,0 +1,39 @@
+#include "BeamSearch.h"
+#include "utils/Debug.h"
+#include <llvm/ADT/DenseSet.h>
+
+using namespace llvm;
+
+void BeamSearch::search() {
+  std::vector<std::string> Beam = {""};
+  for (unsigned Depth = 1; Depth <= Length && !isOverBudget(); ++Depth) {
+    std::vector<std::string> Candidates;
+    for (const std::string &Sequence : Beam)
+      for (unsigned P = 0; P < NumPasses; ++P)
+        Candidates.push_back(Sequence + char('0' + P));
+    auto Results = evaluateAll(Candidates);
+
+    std::vector<unsigned> Order;
+    for (unsigned I = 0; I < Candidates.size(); ++I)
+      if (Results[I])
+        Order.push_back(I);
+    llvm::stable_sort(Order, [&](unsigned A, unsigned B) {
+      return Results[A]->Gain > Results[B]->Gain;
+    });
+
+    std::vector<std::string> Next;
+    DenseSet<const std::string *> Seen;
+    for (unsigned I : Order) {
+      if (Next.size() == Width)
+        break;
+      if (Seen.insert(Results[I]->Optimized.get()).second)
+        Next.push_back(Candidates[I]);
+    }
+    if (Next.empty())
+      break;
+    Beam = std::move(Next);
+    MODEBUG(dbgs() << "[BeamSearch] Length " << Depth << ": best gain "
+                   << Results[Order.front()]->Gain << ", "
+                   << getNumOptimized() << " optimized\n");
+  }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "SequenceSearch.h"
+
+namespace llvm {
+
+/*
+ * Extend the Width prefixes with the largest static profile gain by every
+ * pass, one pass at a time, until the sequences have the given length or the
+ * budget is spent. Prefixes optimizing to the same module as a better one are
+ * dropped, so that the beam does not fill up with no-ops.
+ */
+
+class BeamSearch : public SequenceSearch {
+public:
+  BeamSearch(const Module &M, unsigned Length, unsigned long Seed,
+             unsigned Jobs, unsigned Budget, unsigned Width)
+      : SequenceSearch(M, Length, Seed, Jobs, Budget), Width(Width) {}
+
+protected:
+  void search() override;
+
+private:
+  unsigned Width;
+};
+
+} // namespace llvm
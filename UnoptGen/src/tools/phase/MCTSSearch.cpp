@@ -0,0 +1,87 @@
+#include "MCTSSearch.h"
+#include "utils/Debug.h"
+#include <cmath>
+
+using namespace llvm;
+
+std::vector<MCTSSearch::Node *> MCTSSearch::select(Node &Root) {
+  std::vector<Node *> Path = {&Root};
+  Node *N = &Root;
+  while (N->Sequence.size() < Length) {
+    if (N->Children.empty())
+      N->Children.resize(NumPasses);
+
+    std::vector<unsigned> Untried;
+    for (unsigned P = 0; P < NumPasses; ++P)
+      if (!N->Children[P])
+        Untried.push_back(P);
+    if (!Untried.empty()) {
+      unsigned P = Untried[Gen() % Untried.size()];
+      N->Children[P] = std::make_unique<Node>();
+      N->Children[P]->Sequence = N->Sequence + char('0' + P);
+      Path.push_back(N->Children[P].get());
+      break;
+    }
+
+    Node *Best = nullptr;
+    double BestScore = -INFINITY;
+    for (auto &Child : N->Children) {
+      double Score =
+          Child->Reward / Child->Visits +
+          Exploration * std::sqrt(std::log(N->Visits) / Child->Visits);
+      if (Score > BestScore) {
+        Best = Child.get();
+        BestScore = Score;
+      }
+    }
+    N = Best;
+    Path.push_back(N);
+  }
+  return Path;
+}
+
+std::string MCTSSearch::complete(StringRef Sequence) {
+  std::string Completed = Sequence.str();
+  while (Completed.size() < Length)
+    Completed += char('0' + Gen() % NumPasses);
+  return Completed;
+}
+
+void MCTSSearch::search() {
+  if (Length == 0)
+    return;
+
+  Node Root;
+  // Revisiting known sequences costs no budget; bound the descents too.
+  uint64_t MaxDescents = 16ULL * Budget;
+  uint64_t Descents = 0;
+  while (!isOverBudget() && Descents < MaxDescents) {
+    std::vector<std::vector<Node *>> Paths;
+    std::vector<std::string> Completions;
+    for (unsigned I = 0; I < Pool.getThreadCount(); ++I) {
+      Paths.push_back(select(Root));
+      for (Node *N : Paths.back())
+        ++N->Visits;
+      Completions.push_back(complete(Paths.back().back()->Sequence));
+    }
+    Descents += Paths.size();
+
+    std::vector<std::optional<Evaluation>> Results(Paths.size());
+    for (unsigned I = 0; I < Paths.size(); ++I)
+      Pool.async([this, &Paths, &Completions, &Results, I] {
+        getSnapshot(Paths[I].back()->Sequence);
+        Results[I] = evaluate(Completions[I], /*Keep=*/false);
+      });
+    Pool.wait();
+
+    for (unsigned I = 0; I < Paths.size(); ++I) {
+      if (!Results[I])
+        continue;
+      offer(Completions[I], *Results[I]);
+      for (Node *N : Paths[I])
+        N->Reward += Results[I]->Gain;
+    }
+  }
+  MODEBUG(dbgs() << "[MCTSSearch] " << Descents << " descents, "
+                 << getNumOptimized() << " optimized\n");
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "SequenceSearch.h"
+#include <cassert>
+#include <random>
+
+namespace llvm {
+
+/*
+ * Monte-Carlo tree search over the sequences: descend the tree of prefixes by
+ * UCT, expand one untried pass, complete the sequence with random passes and
+ * back up its static profile gain. A batch of descents, one per thread, runs
+ * at a time; a descent counts as a visit before its reward is known, so that
+ * the batch spreads over the tree.
+ *
+ * Only the snapshots of the tree nodes are cached, not those of the random
+ * completions.
+ */
+
+class MCTSSearch : public SequenceSearch {
+public:
+  // Budget must be positive: revisiting known sequences is free, so the
+  // search would not end without one.
+  MCTSSearch(const Module &M, unsigned Length, unsigned long Seed,
+             unsigned Jobs, unsigned Budget, double Exploration)
+      : SequenceSearch(M, Length, Seed, Jobs, Budget),
+        Exploration(Exploration), Gen(Seed) {
+    assert(Budget && "MCTS needs a budget");
+  }
+
+protected:
+  void search() override;
+
+private:
+  struct Node {
+    std::string Sequence;
+    unsigned Visits = 0;
+    double Reward = 0;
+    // By pass, null if not expanded yet
+    std::vector<std::unique_ptr<Node>> Children;
+  };
+
+  // Descend from Root to a new or terminal node, and return the path.
+  std::vector<Node *> select(Node &Root);
+  std::string complete(StringRef Sequence);
+
+  double Exploration;
+  std::mt19937_64 Gen;
+};
+
+} // namespace llvm
@@ -0,0 +1,26 @@
+#include "OrtSearch.h"
+#include "utils/Debug.h"
+
+using namespace llvm;
+
+void OrtSearch::search() {
+  if (Length == 0)
+    return;
+
+  std::vector<std::string> Level = {""};
+  for (unsigned Depth = 1; Depth <= Length; ++Depth) {
+    std::vector<std::string> Next;
+    for (const std::string &Sequence : Level)
+      for (unsigned P = 0; P < NumPasses; ++P)
+        Next.push_back(Sequence + char('0' + P));
+    Level = std::move(Next);
+
+    // Only the leaves are optimized; their snapshots are not needed after.
+    if (Depth < Length)
+      snapshotAll(Level);
+    else
+      evaluateAll(Level, /*Keep=*/false);
+    MODEBUG(dbgs() << "[OrtSearch] Level " << Depth << ": " << Level.size()
+                   << " sequences, " << getNumOptimized() << " optimized\n");
+  }
+}
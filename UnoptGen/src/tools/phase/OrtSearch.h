@@ -0,0 +1,22 @@
+#pragma once
+
+#include "SequenceSearch.h"
+
+namespace llvm {
+
+/*
+ * Exhaustive search over the sequences of the given length, compared with the
+ * best so far in breadth-first order, like the ORT search of fibo.py. Every
+ * level of the trie is built from the snapshots of the level above. It does
+ * not scale beyond a length of about 4.
+ */
+
+class OrtSearch : public SequenceSearch {
+public:
+  using SequenceSearch::SequenceSearch;
+
+protected:
+  void search() override;
+};
+
+} // namespace llvm
@@ -0,0 +1,165 @@
+#include "PassBFS.h"
+#include "SequenceSearch.h"
+#include "engine/Optimizer.h"
+#include "transforms/IRNormalizer/IRNormalizer.h"
+#include "utils/Debug.h"
+#include "utils/Files.h"
+#include "utils/Hash.h"
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/ThreadPool.h>
+#include <algorithm>
+
+using namespace llvm;
+
+// Agreements of the orders of a pair of passes before they are taken to
+// commute on the input.
+static constexpr unsigned MinAgreements = 3;
+
+PassBFS::PassBFS(const Module &M, std::vector<std::string> Passes,
+                 unsigned MaxDepth, unsigned MaxStates, unsigned Jobs,
+                 bool PruneCommuting)
+    : Input(WriteBitcode(M)), Passes(std::move(Passes)), MaxDepth(MaxDepth),
+      MaxStates(MaxStates), Jobs(Jobs), PruneCommuting(PruneCommuting) {}
+
+std::optional<PassBFS::State> PassBFS::apply(const State &S, unsigned Pass) {
+  State Child;
+  Child.Hash = S.Hash;
+  Child.Parent = S.Hash;
+  Child.Sequence = S.Sequence;
+  Child.Sequence.push_back(Pass);
+
+  LLVMContext Context;
+  std::unique_ptr<Module> M = ParseBitcode(*S.Bitcode, Context);
+  Optimizer O(Passes[Pass]);
+  if (!M || O.run(*M))
+    return std::nullopt;
+  if (!O.hasChanged())
+    return Child;
+  normalizeModule(*M);
+  Child.Hash = hashModule(*M);
+  if (Child.Hash != S.Hash)
+    Child.Bitcode = std::make_shared<const std::string>(WriteBitcode(*M));
+  return Child;
+}
+
+void PassBFS::learnCommutations(ArrayRef<State> Level) {
+  for (const State &S : Level) {
+    if (S.Sequence.empty())
+      continue;
+    unsigned B = S.Sequence.back();
+    for (unsigned A = 0; A < Passes.size(); ++A) {
+      // S is Parent;B, compare Parent;B;A with Parent;A;B.
+      auto BA = Steps.find({S.Hash, A});
+      auto ParentA = Steps.find({S.Parent, A});
+      if (A == B || BA == Steps.end() || ParentA == Steps.end())
+        continue;
+      auto AB = Steps.find({ParentA->second, B});
+      if (AB == Steps.end())
+        continue;
+      std::pair<unsigned, unsigned> Pair = std::minmax(A, B);
+      if (!Observed.insert({S.Parent, Pair.first, Pair.second}).second)
+        continue;
+      if (AB->second == BA->second)
+        ++Agreements[Pair];
+      else
+        Disagreements.insert(Pair);
+    }
+  }
+}
+
+bool PassBFS::isCommuting(unsigned A, unsigned B) const {
+  std::pair<unsigned, unsigned> Pair = std::minmax(A, B);
+  auto It = Agreements.find(Pair);
+  return It != Agreements.end() && It->second >= MinAgreements &&
+         !Disagreements.contains(Pair);
+}
+
+bool PassBFS::run() {
+  PassBuilder PB;
+  for (const std::string &Pass : Passes) {
+    ModulePassManager MPM;
+    if (Error Err = PB.parsePassPipeline(MPM, Pass)) {
+      errs() << "Invalid pass " << Pass << ": " << toString(std::move(Err))
+             << "\n";
+      return false;
+    }
+  }
+
+  // The input is normalized like the states, phase.py did it on children
+  // only.
+  LLVMContext Context;
+  std::unique_ptr<Module> BestModule = ParseBitcode(Input, Context);
+  if (!BestModule)
+    return false;
+  normalizeModule(*BestModule);
+
+  State Root;
+  Root.Bitcode = std::make_shared<const std::string>(WriteBitcode(*BestModule));
+  Root.Hash = hashModule(*BestModule);
+  Best = Root.Bitcode;
+  BestSequence.clear();
+  Visited = {Root.Hash};
+
+  ThreadPool Pool(Jobs ? hardware_concurrency(Jobs) : hardware_concurrency());
+  std::vector<State> Level = {Root};
+  for (unsigned Depth = 0; !Level.empty(); ++Depth) {
+    for (const State &S : Level) {
+      ++NumStates;
+      std::unique_ptr<Module> Current = ParseBitcode(*S.Bitcode, Context);
+      if (!Current || !isAnyFunctionBetter(*Current, *BestModule))
+        continue;
+      Best = S.Bitcode;
+      BestModule = std::move(Current);
+      BestSequence.clear();
+      for (unsigned Pass : S.Sequence)
+        BestSequence.push_back(Passes[Pass]);
+      MODEBUG(dbgs() << "[PassBFS] Better after " << NumStates
+                     << " states\n");
+    }
+    if ((MaxDepth && Depth == MaxDepth) ||
+        (MaxStates && NumStates >= MaxStates))
+      break;
+
+    // Parent;B;A is skipped for A < B if they commute, Parent;A;B is built
+    // instead.
+    std::vector<std::optional<State>> Children(Level.size() * Passes.size());
+    for (unsigned I = 0; I < Level.size(); ++I)
+      for (unsigned P = 0; P < Passes.size(); ++P) {
+        const std::vector<unsigned> &Sequence = Level[I].Sequence;
+        if (PruneCommuting && !Sequence.empty() && P < Sequence.back() &&
+            isCommuting(P, Sequence.back())) {
+          ++NumPruned;
+          continue;
+        }
+        Pool.async([&, I, P] {
+          Children[I * Passes.size() + P] = apply(Level[I], P);
+        });
+      }
+    Pool.wait();
+
+    std::vector<State> Next;
+    for (unsigned I = 0; I < Children.size(); ++I) {
+      std::optional<State> &Child = Children[I];
+      if (!Child)
+        continue;
+      Steps[{Level[I / Passes.size()].Hash, I % Passes.size()}] = Child->Hash;
+      if (!Child->Bitcode)
+        ++NumNoOps;
+      else if (Visited.insert(Child->Hash).second)
+        Next.push_back(std::move(*Child));
+    }
+    if (PruneCommuting)
+      learnCommutations(Level);
+    if (MaxStates && NumStates + Next.size() > MaxStates)
+      Next.resize(MaxStates - NumStates);
+    Level = std::move(Next);
+    MODEBUG(dbgs() << "[PassBFS] Depth " << Depth + 1 << ": " << Level.size()
+                   << " new states, " << Visited.size() << " distinct, "
+                   << NumNoOps << " no-ops, " << NumPruned << " pruned\n");
+  }
+  return true;
+}
+
+std::unique_ptr<Module> PassBFS::getBest(LLVMContext &Context) const {
+  return Best ? ParseBitcode(*Best, Context) : nullptr;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace llvm {
+
+/*
+ * Breadth-first search over the orders of optimization passes, like
+ * phase.py: every state is expanded by each pass of a list, the children are
+ * normalized and deduplicated by structural hash, and the states are compared
+ * with the best so far in breadth-first order. The passes are parsed once
+ * with parsePassPipeline and run in-process; the children of a level are
+ * built on a thread pool, each in its own LLVMContext.
+ *
+ * Two kinds of children are pruned. A pass that preserves all analyses, or
+ * after which the hash is unchanged, is a no-op: its child is its parent and
+ * is neither serialized nor expanded. And the search learns which pairs of
+ * passes commute on the input, from the states where both orders have been
+ * built; once a pair agrees often enough and never disagrees, only the order
+ * with the lower index first is expanded, the other reaching the same state.
+ * That is a heuristic: a pruned order is never built again, so a later
+ * disagreement goes unseen and distinct states may be lost. The no-op pruning
+ * is exact; the commutation pruning is off unless asked for.
+ */
+
+class PassBFS {
+public:
+  // Expand up to MaxDepth levels and MaxStates states, unlimited if 0.
+  // Prune the orders of commuting passes if PruneCommuting is set.
+  PassBFS(const Module &M, std::vector<std::string> Passes, unsigned MaxDepth,
+          unsigned MaxStates, unsigned Jobs, bool PruneCommuting = false);
+
+  // Return false if a pass does not parse.
+  bool run();
+
+  const std::vector<std::string> &getBestSequence() const {
+    return BestSequence;
+  }
+  std::unique_ptr<Module> getBest(LLVMContext &Context) const;
+
+  unsigned getNumStates() const { return NumStates; }
+  // Children that were no-ops, and that were pruned as commuted orders
+  unsigned getNumNoOps() const { return NumNoOps; }
+  unsigned getNumPruned() const { return NumPruned; }
+
+private:
+  struct State {
+    // Null for a no-op child
+    std::shared_ptr<const std::string> Bitcode;
+    uint64_t Hash;
+    // Hash of the state this one was first built from
+    uint64_t Parent = 0;
+    // Indices into Passes
+    std::vector<unsigned> Sequence;
+  };
+
+  // Apply a pass to S, normalized. Return std::nullopt on failure.
+  std::optional<State> apply(const State &S, unsigned Pass);
+
+  // Compare both orders of the passes around every state of Level whose
+  // children are built, and record the verdict once per parent and pair.
+  void learnCommutations(ArrayRef<State> Level);
+  bool isCommuting(unsigned A, unsigned B) const;
+
+  std::string Input;
+  std::vector<std::string> Passes;
+  unsigned MaxDepth;
+  unsigned MaxStates;
+  unsigned Jobs;
+  bool PruneCommuting;
+
+  DenseSet<uint64_t> Visited;
+  // Hash of the child of a state by a pass
+  DenseMap<std::pair<uint64_t, unsigned>, uint64_t> Steps;
+  // Parents and pairs of passes, lower index first, whose orders are
+  // compared
+  DenseSet<std::tuple<uint64_t, unsigned, unsigned>> Observed;
+  // Number of times the orders of a pair agreed; the pairs that ever
+  // disagreed are dropped
+  DenseMap<std::pair<unsigned, unsigned>, unsigned> Agreements;
+  DenseSet<std::pair<unsigned, unsigned>> Disagreements;
+
+  unsigned NumStates = 0;
+  unsigned NumNoOps = 0;
+  unsigned NumPruned = 0;
+
+  std::vector<std::string> BestSequence;
+  std::shared_ptr<const std::string> Best;
+};
+
+} // namespace llvm
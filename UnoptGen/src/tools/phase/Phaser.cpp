@@ -1,16 +1,5 @@
 #include "Phaser.h"
-#include "transforms/CFGExpand/CFGExpand.h"
-#include "transforms/CFGRandomSimplify/CFGRandomSimplify.h"
-#include "transforms/ExprExpand/ExprExpandPass.h"
-#include "transforms/InstRandomCombine/InstRandomCombine.h"
-#include "transforms/RandomCVP/RandomCVP.h"
-#include "transforms/RandomDSE/RandomDSE.h"
-#include "transforms/RandomLICM/RandomLICM.h"
-#include "transforms/RandomLoopSink/RandomLoopSink.h"
-#include "transforms/RandomMem2Reg/RandomMem2Reg.h"
-#include "transforms/RandomReg2Mem/RandomReg2Mem.h"
-#include "transforms/RandomScalarizer/RandomScalarizer.h"
-#include "transforms/RandomSink/RandomSink.h"
+#include "engine/MutationPasses.h"
 #include "utils/Debug.h"
 #include "utils/Files.h"
 #include "utils/Random.h"
@@ -27,48 +16,81 @@
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/Pass.h>
 #include <llvm/Passes/PassBuilder.h>
-#include <llvm/Transforms/InstCombine/InstCombine.h>
-#include <llvm/Transforms/Scalar/CorrelatedValuePropagation.h>
-#include <llvm/Transforms/Scalar/DeadStoreElimination.h>
-#include <llvm/Transforms/Scalar/LoopPassManager.h>
-#include <llvm/Transforms/Scalar/LoopSimplifyCFG.h>
-#include <llvm/Transforms/Scalar/Reassociate.h>
-#include <llvm/Transforms/Scalar/SCCP.h>
-#include <llvm/Transforms/Scalar/SimplifyCFG.h>
-#include <llvm/Transforms/Utils/Cloning.h>
-#include <llvm/Transforms/Utils/LCSSA.h>
-#include <llvm/Transforms/Utils/Mem2Reg.h>
-#include <llvm/Transforms/Vectorize/LoopVectorize.h>
-#include <llvm/Transforms/Vectorize/SLPVectorizer.h>
+#include <llvm/Support/xxhash.h>
 #include <random>
 #include <string>
 
 using namespace llvm;
 
-static cl::opt<std::string> passes("passes", cl::desc("<passes>"));
+static cl::opt<std::string>
+    passes("passes", cl::desc("Comma-separated mutation passes, or digits "
+                              "indexing -search-passes"));
 
-#define PASS_CREATOR(Pass, Weight, Name)                                       \
-  {                                                                            \
-    [](FunctionPassManager &FPM) { FPM.addPass(Pass); }, (Weight), (Name)      \
+static cl::opt<std::string> SearchPasses(
+    "search-passes",
+    cl::desc("Comma-separated mutation passes the searches choose from, or "
+             "\"all\""),
+    // The deoptimizing table of Mutator
+    cl::init("random-inst-expand,random-cfg-expand,random-sink,"
+             "random-reg2mem,random-loopsink,random-scalarizer"));
+
+void Phaser::generateOrReadPipeline() {}
+
+void Phaser::storeConfig() {}
+
+const std::vector<std::string> &Phaser::getSearchPasses() {
+  static const std::vector<std::string> Passes =
+      SearchPasses == "all" ? getMutationPassNames()
+                            : parseMutationPipeline(SearchPasses);
+  return Passes;
+}
+
+unsigned Phaser::getNumPasses() { return getSearchPasses().size(); }
+
+std::vector<std::string> Phaser::parsePipeline(StringRef Pipeline) {
+  if (Pipeline.empty() || !all_of(Pipeline, isDigit))
+    return parseMutationPipeline(Pipeline);
+
+  // A digit out of range is left as is, to be reported as unknown.
+  std::vector<std::string> Passes;
+  for (char C : Pipeline) {
+    unsigned Index = C - '0';
+    Passes.push_back(Index < getNumPasses() ? getSearchPasses()[Index]
+                                            : std::string(1, C));
   }
+  return Passes;
+}
 
-typedef std::function<void(FunctionPassManager &)> FuncPassBuilder;
-typedef std::tuple<FuncPassBuilder, int, std::string> PassEntry;
+ulong Phaser::getPassSeed(ulong Seed, StringRef Sequence) {
+  return Seed ^ xxHash64(Sequence);
+}
 
-static std::vector<PassEntry> PipelineGen = {
-    PASS_CREATOR(ExprExpandPass(), 50, "random-inst-expand"),
-    PASS_CREATOR(CFGExpandPass(), 50, "random-cfg-expand"),
-    PASS_CREATOR(RandomSinkPass(), 50, "random-sink"),
-    PASS_CREATOR(RandomRegToMemPass(), 50, "random-mem2reg"),
-    PASS_CREATOR(RandomLoopSinkPass(), 50, "random-loopsink"),
-    PASS_CREATOR(RandomScalarizerPass(), 50, "random-scalarizer"),
-};
+int Phaser::mutate(Module &M) { return mutate(M, parsePipeline(passes)); }
 
-void Phaser::generateOrReadPipeline() {}
+int Phaser::replay(Module &M, ulong Seed) {
+  std::vector<std::string> Pipeline = parsePipeline(passes);
+  std::string Sequence;
+  for (const std::string &Pass : Pipeline) {
+    auto It = find(getSearchPasses(), Pass);
+    if (It == getSearchPasses().end()) {
+      errs() << "Not a search pass " << Pass << "\n";
+      return -1;
+    }
+    Sequence += '0' + (It - getSearchPasses().begin());
+  }
 
-void Phaser::storeConfig() {}
+  bool AnyChanged = false;
+  for (unsigned I = 0; I < Pipeline.size(); ++I) {
+    InstallSeed(getPassSeed(Seed, StringRef(Sequence).take_front(I + 1)));
+    if (mutate(M, Pipeline[I]))
+      return -1;
+    AnyChanged |= Changed;
+  }
+  Changed = AnyChanged;
+  return 0;
+}
 
-int Phaser::mutate(Module &M) {
+int Phaser::mutate(Module &M, ArrayRef<std::string> Pipeline) {
 
   LoopAnalysisManager LAM;
   FunctionAnalysisManager FAM;
@@ -85,13 +107,14 @@ int Phaser::mutate(Module &M) {
   FunctionPassManager FPM;
   ModulePassManager MPM;
 
-  std::string PassesStr = passes;
-  for (int i = 0; i < PassesStr.size(); i++) {
-    auto &[Builder, _, Name] = PipelineGen[PassesStr[i] - '0'];
-    Builder(FPM);
+  for (const std::string &Pass : Pipeline) {
+    if (!addMutationPass(FPM, Pass)) {
+      errs() << "Unknown mutation pass " << Pass << "\n";
+      return -1;
+    }
   }
 
   MPM.addPass(createModuleToFunctionPassAdaptor(std::move(FPM)));
-  MPM.run(M, MAM);
+  Changed = !MPM.run(M, MAM).areAllPreserved();
   return 0;
 }
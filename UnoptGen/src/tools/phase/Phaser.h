@@ -1,6 +1,9 @@
 #pragma once
 
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/IR/Module.h>
+#include <string>
+#include <vector>
 
 namespace llvm {
 
@@ -13,9 +16,27 @@ class Phaser {
 public:
   Phaser(const std::string &PipelineFile) : PipelineFile(PipelineFile) {}
 
-  // Mutate M with a pipeline of semantics-preserving passes (randomized or
-  // determined). Return 0 if succeeding, otherwise return -1.
+  // Mutate M with the pipeline given by -passes. Return 0 if succeeding,
+  // otherwise return -1.
   int mutate(Module &M);
+  // Mutate M with passes of the mutation registry, see MutationPasses.
+  int mutate(Module &M, ArrayRef<std::string> Pipeline);
+  // Mutate M with the pipeline given by -passes like the searches do: every
+  // pass on its own, seeded with getPassSeed(Seed, <sequence up to it>), so
+  // that the sequences they write can be replayed.
+  int replay(Module &M, ulong Seed);
+  // Whether the last mutation may have changed M: false only if every pass
+  // preserved all analyses.
+  bool hasChanged() const { return Changed; }
+
+  // Passes a sequence can choose from, given by -search-passes
+  static const std::vector<std::string> &getSearchPasses();
+  static unsigned getNumPasses();
+  // Passes of a comma-separated pipeline, or of digits indexing the search
+  // passes like the sequences of fibo.py
+  static std::vector<std::string> parsePipeline(StringRef Pipeline);
+  // Seed of the last pass of Sequence, given the seed of the search
+  static ulong getPassSeed(ulong Seed, StringRef Sequence);
   void storeConfig();
 
   void generateOrReadPipeline();
@@ -23,6 +44,7 @@ public:
 private:
   std::string PipelineFile;
   std::vector<std::string> Pipeline;
+  bool Changed = true;
 };
 
 } // namespace llvm
@@ -0,0 +1,210 @@
+#include "SequenceSearch.h"
+#include "Phaser.h"
+#include "engine/Optimizer.h"
+#include "indicators/InstCountIndicator.h"
+#include "indicators/StaticProfileIndicator.h"
+#include "utils/Files.h"
+#include "utils/Hash.h"
+#include "utils/Random.h"
+
+using namespace llvm;
+
+bool llvm::isAnyFunctionBetter(Module &L, Module &R) {
+  InstCountIndicator InstCount;
+  StaticProfileIndicator StaticProfile;
+  for (Function &LF : L) {
+    Function *RF = R.getFunction(LF.getName());
+    if (LF.isDeclaration() || !RF || RF->isDeclaration())
+      continue;
+    if (InstCount.worth(LF, *RF) > 0 && StaticProfile.worth(LF, *RF) > 0)
+      return true;
+  }
+  return false;
+}
+
+SequenceSearch::SequenceSearch(const Module &M, unsigned Length,
+                               unsigned long Seed, unsigned Jobs,
+                               unsigned Budget)
+    : Length(Length), Seed(Seed), Budget(Budget),
+      NumPasses(Phaser::getNumPasses()),
+      Pool(Jobs ? hardware_concurrency(Jobs) : hardware_concurrency()),
+      Input(std::make_shared<const Snapshot>(
+          Snapshot{WriteBitcode(M), hashModule(M)})) {}
+
+std::vector<std::string> SequenceSearch::getPipeline(StringRef Sequence) {
+  const std::vector<std::string> &Passes = Phaser::getSearchPasses();
+  std::vector<std::string> Pipeline;
+  for (char C : Sequence)
+    Pipeline.push_back(Passes[C - '0']);
+  return Pipeline;
+}
+
+std::shared_ptr<const SequenceSearch::Snapshot>
+SequenceSearch::getSnapshot(StringRef Sequence, bool Keep) {
+  std::shared_ptr<const Snapshot> Base = Input;
+  unsigned Known = 0;
+  {
+    std::lock_guard<std::mutex> Guard(Lock);
+    for (unsigned Size = Sequence.size(); Size > 0; --Size) {
+      auto It = Snapshots.find(Sequence.take_front(Size));
+      if (It != Snapshots.end()) {
+        Base = It->second;
+        Known = Size;
+        break;
+      }
+    }
+  }
+  if (Known == Sequence.size())
+    return Base;
+
+  LLVMContext Context;
+  std::unique_ptr<Module> M = ParseBitcode(Base->Bitcode, Context);
+  if (!M)
+    return nullptr;
+  bool Changed = false;
+  for (unsigned I = Known; I < Sequence.size(); ++I) {
+    InstallSeed(Phaser::getPassSeed(Seed, Sequence.take_front(I + 1)));
+    Phaser P("");
+    if (P.mutate(*M, getPipeline(Sequence.substr(I, 1))))
+      return nullptr;
+    if (P.hasChanged())
+      Changed = true;
+    else
+      ++NumNoOps;
+  }
+
+  // Share the snapshot of the prefix if the passes left the module alone.
+  std::shared_ptr<const Snapshot> Result = Base;
+  if (Changed) {
+    uint64_t Hash = hashModule(*M);
+    if (Hash != Base->Hash)
+      Result = std::make_shared<const Snapshot>(
+          Snapshot{WriteBitcode(*M), Hash});
+    else
+      ++NumNoOps;
+  }
+  if (Keep) {
+    std::lock_guard<std::mutex> Guard(Lock);
+    Snapshots[Sequence] = Result;
+  }
+  return Result;
+}
+
+void SequenceSearch::snapshotAll(ArrayRef<std::string> Sequences) {
+  for (const std::string &Sequence : Sequences)
+    Pool.async([this, &Sequence] { getSnapshot(Sequence); });
+  Pool.wait();
+}
+
+double SequenceSearch::getGain(Module &M) {
+  double Gain = 0;
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    auto It = InputCosts.find(F.getName());
+    if (It == InputCosts.end())
+      continue;
+    double Cost = StaticProfileIndicator::getCost(F);
+    Gain += (It->second - Cost) / std::max(It->second, 1.0);
+  }
+  return Gain;
+}
+
+bool SequenceSearch::reserveRun() {
+  // Count the run before optimizing, so that concurrent evaluations cannot
+  // all pass the check and overrun the budget.
+  unsigned Done = NumOptimized;
+  do {
+    if (Budget && Done >= Budget)
+      return false;
+  } while (!NumOptimized.compare_exchange_weak(Done, Done + 1));
+  return true;
+}
+
+std::optional<SequenceSearch::Evaluation>
+SequenceSearch::evaluate(StringRef Sequence, bool Keep) {
+  std::shared_ptr<const Snapshot> S = getSnapshot(Sequence, Keep);
+  if (!S)
+    return std::nullopt;
+  ++NumSequences;
+
+  {
+    std::lock_guard<std::mutex> Guard(Lock);
+    auto It = Evaluations.find(S->Hash);
+    if (It != Evaluations.end())
+      return It->second;
+  }
+
+  if (!reserveRun())
+    return std::nullopt;
+  LLVMContext Context;
+  std::unique_ptr<Module> M = ParseBitcode(S->Bitcode, Context);
+  if (!M)
+    return std::nullopt;
+  if (Optimizer("-O3").run(*M))
+    return std::nullopt;
+
+  Evaluation E;
+  E.Optimized = std::make_shared<const std::string>(WriteBitcode(*M));
+  E.Gain = getGain(*M);
+  std::lock_guard<std::mutex> Guard(Lock);
+  return Evaluations.try_emplace(S->Hash, E).first->second;
+}
+
+std::vector<std::optional<SequenceSearch::Evaluation>>
+SequenceSearch::evaluateAll(ArrayRef<std::string> Sequences, bool Keep) {
+  std::vector<std::optional<Evaluation>> Results(Sequences.size());
+  for (unsigned I = 0; I < Sequences.size(); ++I)
+    Pool.async([this, &Sequences, &Results, I, Keep] {
+      Results[I] = evaluate(Sequences[I], Keep);
+    });
+  Pool.wait();
+
+  for (unsigned I = 0; I < Sequences.size(); ++I)
+    if (Results[I])
+      offer(Sequences[I], *Results[I]);
+  return Results;
+}
+
+void SequenceSearch::offer(StringRef Sequence, const Evaluation &E) {
+  if (E.Optimized == Best)
+    return;
+  std::unique_ptr<Module> Candidate = ParseBitcode(*E.Optimized, BestContext);
+  if (!Candidate || !isAnyFunctionBetter(*Candidate, *BestModule))
+    return;
+  BestSequence = Sequence.str();
+  Best = E.Optimized;
+  BestModule = std::move(Candidate);
+}
+
+bool SequenceSearch::run() {
+  LLVMContext Context;
+  std::unique_ptr<Module> M = ParseBitcode(Input->Bitcode, Context);
+  if (!M)
+    return false;
+  if (Optimizer("-O3").run(*M))
+    return false;
+  ++NumOptimized;
+
+  for (Function &F : *M)
+    if (!F.isDeclaration())
+      InputCosts[F.getName()] = StaticProfileIndicator::getCost(F);
+
+  Evaluation E;
+  E.Optimized = std::make_shared<const std::string>(WriteBitcode(*M));
+  E.Gain = 0;
+  Evaluations[Input->Hash] = E;
+
+  BestSequence = "";
+  Best = E.Optimized;
+  BestModule = ParseBitcode(*Best, BestContext);
+  if (!BestModule)
+    return false;
+
+  search();
+  return true;
+}
+
+std::unique_ptr<Module> SequenceSearch::getBest(LLVMContext &Context) const {
+  return Best ? ParseBitcode(*Best, Context) : nullptr;
+}
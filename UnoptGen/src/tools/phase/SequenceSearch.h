@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/ThreadPool.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace llvm {
+
+// Whether some function of L is better than in R, like `mochecker -all
+// -perf`.
+bool isAnyFunctionBetter(Module &L, Module &R);
+
+/*
+ * Search for the sequence of deoptimizing passes after which -O3 optimizes
+ * the input the best. A sequence has a character per pass, '0' plus its index
+ * into the search passes of Phaser.
+ *
+ * The strategies share two caches. The snapshot cache keeps the mutated
+ * bitcode of prefixes and its structural hash, so a sequence is built from
+ * its longest known prefix. The evaluation memo keeps the optimized module of
+ * every mutated module by that hash, since many sequences leave the module
+ * alone. A pass that preserves all analyses, or after which the hash is
+ * unchanged, is a no-op: its sequence shares the snapshot of its prefix and
+ * hits the memo without parsing any bitcode. Evaluations run on a thread
+ * pool, each in its own LLVMContext.
+ *
+ * Every pass is seeded with the seed and its sequence, see
+ * Phaser::getPassSeed, so that a sequence mutates the same way whatever else
+ * is searched. `phaser -passes=<sequence> -seed-per-pass -s <seed>` replays
+ * it.
+ */
+
+class SequenceSearch {
+public:
+  struct Evaluation {
+    // Bitcode of the sequence applied and optimized
+    std::shared_ptr<const std::string> Optimized;
+    // Static profile cost saved over the optimized input, relative to the
+    // cost of every function and summed over them
+    double Gain;
+  };
+
+  // Length is the length of the sequences; Budget the number of -O3 runs
+  // allowed, unlimited if 0.
+  SequenceSearch(const Module &M, unsigned Length, unsigned long Seed,
+                 unsigned Jobs, unsigned Budget);
+  virtual ~SequenceSearch() = default;
+
+  // Return false if the input cannot be optimized.
+  bool run();
+
+  const std::string &getBestSequence() const { return BestSequence; }
+  // Names of the passes of Sequence
+  static std::vector<std::string> getPipeline(StringRef Sequence);
+  // The best sequence applied and optimized
+  std::unique_ptr<Module> getBest(LLVMContext &Context) const;
+
+  unsigned getNumOptimized() const { return NumOptimized; }
+  unsigned getNumSequences() const { return NumSequences; }
+  // Passes applied that left the module unchanged
+  unsigned getNumNoOps() const { return NumNoOps; }
+
+protected:
+  struct Snapshot {
+    std::string Bitcode;
+    uint64_t Hash;
+  };
+
+  virtual void search() = 0;
+
+  // Mutated module of Sequence, built from its longest cached prefix. It is
+  // cached too if Keep is set.
+  std::shared_ptr<const Snapshot> getSnapshot(StringRef Sequence,
+                                              bool Keep = true);
+  // Build the snapshots of Sequences on the pool.
+  void snapshotAll(ArrayRef<std::string> Sequences);
+
+  std::optional<Evaluation> evaluate(StringRef Sequence, bool Keep = true);
+  // Evaluate Sequences on the pool, and offer them in order.
+  std::vector<std::optional<Evaluation>>
+  evaluateAll(ArrayRef<std::string> Sequences, bool Keep = true);
+
+  // Take Sequence as the best if it beats the best so far, like `mochecker
+  // -all -perf`. The verdicts are not transitive, so the order matters.
+  void offer(StringRef Sequence, const Evaluation &E);
+
+  bool isOverBudget() const { return Budget && NumOptimized >= Budget; }
+
+  unsigned Length;
+  unsigned long Seed;
+  unsigned Budget;
+  unsigned NumPasses;
+  ThreadPool Pool;
+
+private:
+  double getGain(Module &M);
+  // Take a run of -O3 from the budget, or return false if none is left.
+  bool reserveRun();
+
+  std::shared_ptr<const Snapshot> Input;
+  // Static profile cost of every function of the optimized input
+  StringMap<double> InputCosts;
+
+  std::mutex Lock;
+  StringMap<std::shared_ptr<const Snapshot>> Snapshots;
+  DenseMap<uint64_t, Evaluation> Evaluations;
+  std::atomic<unsigned> NumOptimized = 0;
+  std::atomic<unsigned> NumSequences = 0;
+  std::atomic<unsigned> NumNoOps = 0;
+
+  std::string BestSequence;
+  std::shared_ptr<const std::string> Best;
+  LLVMContext BestContext;
+  std::unique_ptr<Module> BestModule;
+};
+
+} // namespace llvm
@@ -1,13 +1,20 @@
+#include "engine/MutationPasses.h"
+#include "tools/phase/BeamSearch.h"
+#include "tools/phase/MCTSSearch.h"
+#include "tools/phase/OrtSearch.h"
+#include "tools/phase/PassBFS.h"
 #include "tools/phase/Phaser.h"
 #include "utils/Debug.h"
 #include "utils/Files.h"
 #include "utils/Random.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/WithColor.h"
 #include <cstdlib>
 #include <format>
 #include <iostream>
+#include <llvm/ADT/StringExtras.h>
 #include <llvm/Analysis/CGSCCPassManager.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Instructions.h>
@@ -28,27 +35,181 @@ static cl::opt<std::string> InputFile(cl::Positional,
                                       cl::desc("<File to mutate>"),
                                       cl::Required, cl::cat(UnoptGenOptions));
 
-static cl::opt<std::string> OutputFile("o", cl::desc("File to output"),
-                                       cl::cat(UnoptGenOptions), cl::init(""));
+static cl::opt<std::string>
+    OutputFile("o", cl::desc("File to output, directory with -search"),
+               cl::cat(UnoptGenOptions), cl::init(""));
 
 static cl::opt<std::string> SeedFile("s", cl::desc("Seed file"),
                                      cl::cat(UnoptGenOptions), cl::init(""));
 
+enum SearchKind {
+  NoSearch,
+  OrtSearchKind,
+  BeamSearchKind,
+  MCTSSearchKind,
+  BFSSearchKind
+};
+static cl::opt<SearchKind> Search(
+    "search", cl::desc("Search for the best sequence of passes"),
+    cl::values(clEnumValN(OrtSearchKind, "ort",
+                          "All sequences of length k, like fibo.py"),
+               clEnumValN(BeamSearchKind, "beam", "Beam search"),
+               clEnumValN(MCTSSearchKind, "mcts", "Monte-Carlo tree search"),
+               clEnumValN(BFSSearchKind, "bfs",
+                          "Orders of the passes of -passes-file, like "
+                          "phase.py")),
+    cl::init(NoSearch), cl::cat(UnoptGenOptions));
+static cl::opt<unsigned> SearchDepth("k", cl::desc("Length of the sequences"),
+                                     cl::init(4), cl::cat(UnoptGenOptions));
+static cl::opt<unsigned>
+    Budget("budget",
+           cl::desc("Runs of -O3 a search may take, 6^4 by default, "
+                    "unlimited for ort"),
+           cl::init(1296), cl::cat(UnoptGenOptions));
+static cl::opt<unsigned> BeamWidth("beam-width",
+                                   cl::desc("Prefixes kept by beam search"),
+                                   cl::init(8), cl::cat(UnoptGenOptions));
+static cl::opt<double>
+    Exploration("exploration",
+                cl::desc("Exploration constant of the UCT of mcts"),
+                cl::init(1.4), cl::cat(UnoptGenOptions));
+static cl::opt<std::string>
+    PassesFile("passes-file", cl::desc("Passes to order, one per line"),
+               cl::init(""), cl::cat(UnoptGenOptions));
+static cl::opt<bool>
+    PruneCommuting("prune-commuting",
+                   cl::desc("Expand one order of the passes that commute on "
+                            "the input in -search=bfs, which may miss states"),
+                   cl::init(false), cl::cat(UnoptGenOptions));
+static cl::opt<bool>
+    SeedPerPass("seed-per-pass",
+                cl::desc("Seed every pass of -passes with -s and the passes "
+                         "up to it, to replay the sequences of -search"),
+                cl::cat(UnoptGenOptions));
+static cl::opt<unsigned> Jobs("j", cl::desc("Number of threads to search with"),
+                              cl::init(0), cl::cat(UnoptGenOptions));
 
 static std::unique_ptr<Module> readModule(LLVMContext &Context,
                                           StringRef Name) {
   SMDiagnostic Diag;
-  std::unique_ptr<Module> M = parseIRFile(Name, Diag, Context);
+  std::unique_ptr<Module> M = ParseIRFile(Name.str(), Diag, Context);
   if (!M)
     Diag.print("phase", errs());
   return M;
 }
 
 static void writeModule(Module &M, StringRef Name) {
-  // TODO: Support bitcode writer
-  std::error_code EC;
-  raw_fd_ostream Out(Name, EC, sys::fs::OF_Text);
-  M.print(Out, nullptr);
+  WriteModule(M, Name.str());
+}
+
+// Write the best order of passes and its module to the output directory, as
+// sequence.txt and phased.ll. Depth and states are limited only if -k and
+// -budget are given.
+static int searchOrders(Module &M) {
+  std::vector<std::string> Passes = ReadPipeline(PassesFile);
+  if (Passes.empty()) {
+    errs() << "-search=bfs needs a -passes-file\n";
+    return -1;
+  }
+
+  PassBFS Searcher(M, Passes,
+                   SearchDepth.getNumOccurrences() ? SearchDepth.getValue() : 0,
+                   Budget.getNumOccurrences() ? Budget.getValue() : 0, Jobs,
+                   PruneCommuting);
+  if (!Searcher.run())
+    return -1;
+  outs() << ::format("Best of {} states: {}, {} no-ops, {} pruned\n",
+                     Searcher.getNumStates(),
+                     join(Searcher.getBestSequence(), ","),
+                     Searcher.getNumNoOps(), Searcher.getNumPruned());
+
+  SmallString<128> Path(OutputFile.getValue());
+  sys::path::append(Path, "sequence.txt");
+  if (!WriteFile(std::string(Path), join(Searcher.getBestSequence(), ",")))
+    return -1;
+
+  LLVMContext Context;
+  std::unique_ptr<llvm::Module> Best = Searcher.getBest(Context);
+  Path = OutputFile.getValue();
+  sys::path::append(Path, "phased.ll");
+  if (!Best || !WriteModule(*Best, std::string(Path)))
+    return -1;
+  return 0;
+}
+
+// Write the best sequence, the seed and the optimized module to the output
+// directory, as <search><k>_seq.txt, <search><k>_seed.txt and <search><k>.ll.
+// `phaser -passes=<sequence> -seed-per-pass -s <seed>` replays the sequence.
+static int search(Module &M, ulong Seed) {
+  if (OutputFile.empty()) {
+    errs() << "-search needs an output directory\n";
+    return -1;
+  }
+  if (sys::fs::create_directories(OutputFile.getValue())) {
+    errs() << ::format("Cannot create {}\n", OutputFile.getValue());
+    return -1;
+  }
+
+  if (Search == BFSSearchKind)
+    return searchOrders(M);
+
+  for (const std::string &Pass : Phaser::getSearchPasses())
+    if (!isMutationPass(Pass)) {
+      errs() << ::format("Unknown mutation pass {}\n", Pass);
+      return -1;
+    }
+
+  if (Search == MCTSSearchKind && Budget == 0) {
+    errs() << "-search=mcts needs a -budget above 0\n";
+    return -1;
+  }
+
+  std::unique_ptr<SequenceSearch> Searcher;
+  std::string Prefix;
+  if (Search == OrtSearchKind) {
+    Searcher = std::make_unique<OrtSearch>(
+        M, SearchDepth, Seed, Jobs,
+        Budget.getNumOccurrences() ? Budget.getValue() : 0);
+    Prefix = "ort";
+  } else if (Search == BeamSearchKind) {
+    Searcher = std::make_unique<BeamSearch>(M, SearchDepth, Seed, Jobs,
+                                            Budget, BeamWidth);
+    Prefix = "beam";
+  } else {
+    Searcher = std::make_unique<MCTSSearch>(M, SearchDepth, Seed, Jobs,
+                                            Budget, Exploration);
+    Prefix = "mcts";
+  }
+  Prefix += std::to_string(SearchDepth);
+
+  if (!Searcher->run()) {
+    errs() << "Cannot optimize the input\n";
+    return -1;
+  }
+  std::string Pipeline =
+      join(SequenceSearch::getPipeline(Searcher->getBestSequence()), ",");
+  outs() << ::format("Best of {} sequences: \"{}\", {} optimized, "
+                     "{} no-ops\n",
+                     Searcher->getNumSequences(), Pipeline,
+                     Searcher->getNumOptimized(), Searcher->getNumNoOps());
+
+  // The sequence is written as a -passes pipeline.
+  SmallString<128> Path(OutputFile.getValue());
+  sys::path::append(Path, Prefix + "_seq.txt");
+  if (!WriteFile(std::string(Path), Pipeline))
+    return -1;
+  Path = OutputFile.getValue();
+  sys::path::append(Path, Prefix + "_seed.txt");
+  if (WriteSeed(std::string(Path), Seed))
+    return -1;
+
+  LLVMContext Context;
+  std::unique_ptr<llvm::Module> Best = Searcher->getBest(Context);
+  Path = OutputFile.getValue();
+  sys::path::append(Path, Prefix + ".ll");
+  if (!Best || !WriteModule(*Best, std::string(Path)))
+    return -1;
+  return 0;
 }
 
 int main(int Argc, char **Argv) {
@@ -69,10 +230,14 @@ int main(int Argc, char **Argv) {
     return -1;
   }
 
+  if (Search != NoSearch)
+    return search(*Module, Seed);
+
   // Mutate
   Phaser phaser("");
 
-  phaser.mutate(*Module);
+  if (SeedPerPass ? phaser.replay(*Module, Seed) : phaser.mutate(*Module))
+    return -1;
 
   if (OutputFile.empty())
     Module->print(outs(), nullptr);
@@ -1,4 +1,5 @@
-#include "tools/unoptgen/engine/Mutator.h"
+#include "engine/Mutator.h"
+#include "trace/Tracer.h"
 #include "utils/Debug.h"
 #include "utils/Files.h"
 #include "utils/Random.h"
@@ -44,22 +45,23 @@ static cl::opt<std::string> PipelineFile("p", cl::desc("File of pipeline list"),
 static cl::opt<std::string> TraceDir("trace", cl::desc("Directory of traces"),
                                      cl::cat(UnoptGenOptions), cl::init(""));
 
+static cl::opt<std::string>
+    ReplayFile("replay", cl::desc("Trace of decisions to replay"),
+               cl::cat(UnoptGenOptions), cl::init(""));
+
 void mutate(Module &M);
 
 static std::unique_ptr<Module> readModule(LLVMContext &Context,
                                           StringRef Name) {
   SMDiagnostic Diag;
-  std::unique_ptr<Module> M = parseIRFile(Name, Diag, Context);
+  std::unique_ptr<Module> M = ParseIRFile(Name.str(), Diag, Context);
   if (!M)
     Diag.print("momutate", errs());
   return M;
 }
 
 static void writeModule(Module &M, StringRef Name) {
-  // TODO: Support bitcode writer
-  std::error_code EC;
-  raw_fd_ostream Out(Name, EC, sys::fs::OF_Text);
-  M.print(Out, nullptr);
+  WriteModule(M, Name.str());
 }
 
 int main(int Argc, char **Argv) {
@@ -80,6 +82,11 @@ int main(int Argc, char **Argv) {
     return -1;
   }
 
+  if (!ReplayFile.empty() && !Tracer::get()->startReplaying(ReplayFile)) {
+    errs() << ::format("Broken trace: {}\n", ReplayFile.getValue());
+    return -1;
+  }
+
   // Mutate
   Mutator mutator(MaxPasses, PipelineFile, TraceDir);
   mutator.generateOrReadPipeline();
@@ -87,6 +94,9 @@ int main(int Argc, char **Argv) {
 
   mutator.mutate(*Module);
 
+  if (Tracer::get()->hasDiverged())
+    WithColor::warning() << "The mutant diverged from the replayed trace\n";
+
   if (OutputFile.empty())
     Module->print(outs(), nullptr);
   else
@@ -0,0 +1,192 @@
+#include "Tracer.h"
+#include <cstring>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/LEB128.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+using namespace llvm;
+
+static const char Magic[] = {'M', 'O', 'T', 'R'};
+static const uint64_t Version = 2;
+
+Tracer *Tracer::get() {
+  thread_local Tracer Instance;
+  return &Instance;
+}
+
+void Tracer::startRecording(const std::string &Path) {
+  OutputPath = Path;
+  Recorded = Trace();
+  SiteIndices.clear();
+  Recording = true;
+}
+
+bool Tracer::startReplaying(const std::string &Path) {
+  auto T = read(Path);
+  if (!T)
+    return false;
+  startReplaying(*T);
+  return true;
+}
+
+void Tracer::startReplaying(const Trace &T, bool IdleAfterDivergence) {
+  Replayed = T;
+  Cursor = 0;
+  Diverged = false;
+  this->IdleAfterDivergence = IdleAfterDivergence;
+  Replaying = true;
+}
+
+void Tracer::stop() {
+  if (Recording && !OutputPath.empty() && !write(OutputPath, Recorded))
+    errs() << "Cannot write the trace to " << OutputPath << "\n";
+  Recording = false;
+  Replaying = false;
+  OutputPath.clear();
+}
+
+uint32_t Tracer::internSite(const std::source_location &Loc,
+                            std::optional<uint32_t> Idle) {
+  auto [It, Inserted] =
+      SiteIndices.try_emplace({Loc.file_name(), Loc.line(), Loc.column()});
+  if (!Inserted)
+    return It->second;
+
+  std::string Description = sys::path::filename(Loc.file_name()).str() + ":" +
+                            std::to_string(Loc.line()) + " (" +
+                            Loc.function_name() + ")";
+  uint32_t ID = xxHash64(Description);
+  // There are a few dozens of sites, a linear search is fine.
+  for (size_t I = 0; I < Recorded.Sites.size(); ++I)
+    if (Recorded.Sites[I].ID == ID)
+      return It->second = I;
+  Recorded.Sites.push_back({ID, std::move(Description), Idle});
+  return It->second = Recorded.Sites.size() - 1;
+}
+
+std::optional<uint32_t> Tracer::replay(const std::source_location &Loc,
+                                       uint32_t Range,
+                                       std::optional<uint32_t> Idle) {
+  if (!Replaying)
+    return std::nullopt;
+
+  if (!Diverged && Cursor < Replayed.Decisions.size()) {
+    const Decision &D = Replayed.Decisions[Cursor];
+    uint32_t Site = internSite(Loc, Idle);
+    if (D.PassIndex == PassIndex && D.Range == Range &&
+        Replayed.Sites[D.Site].ID == Recorded.Sites[Site].ID) {
+      ++Cursor;
+      return D.Value;
+    }
+  }
+
+  Diverged = true;
+  if (IdleAfterDivergence)
+    return Idle;
+  return std::nullopt;
+}
+
+void Tracer::log(const std::source_location &Loc, uint32_t Range,
+                 uint32_t Value, std::optional<uint32_t> Idle) {
+  if (Recording)
+    Recorded.Decisions.push_back(
+        {PassIndex, internSite(Loc, Idle), Range, Value});
+}
+
+// The trace is a magic, a version, the site table and the decisions, all as
+// ULEB128. Most fields fit in a byte, so a decision takes about four bytes.
+bool Tracer::write(const std::string &Path, const Trace &T) {
+  std::string Buffer;
+  raw_string_ostream OS(Buffer);
+  OS.write(Magic, sizeof(Magic));
+  encodeULEB128(Version, OS);
+
+  encodeULEB128(T.Sites.size(), OS);
+  for (const Site &S : T.Sites) {
+    encodeULEB128(S.ID, OS);
+    encodeULEB128(S.Description.size(), OS);
+    OS << S.Description;
+    // Zero for sites without an idle value
+    encodeULEB128(S.Idle ? *S.Idle + 1 : 0, OS);
+  }
+
+  encodeULEB128(T.Decisions.size(), OS);
+  for (const Decision &D : T.Decisions) {
+    encodeULEB128(D.PassIndex, OS);
+    encodeULEB128(D.Site, OS);
+    encodeULEB128(D.Range, OS);
+    encodeULEB128(D.Value, OS);
+  }
+  OS.flush();
+
+  std::error_code EC;
+  raw_fd_ostream Out(Path, EC, sys::fs::OF_None);
+  if (EC)
+    return false;
+  Out << Buffer;
+  return true;
+}
+
+std::optional<Tracer::Trace> Tracer::read(const std::string &Path) {
+  auto Buffer = MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return std::nullopt;
+
+  const uint8_t *Cur =
+      reinterpret_cast<const uint8_t *>((*Buffer)->getBufferStart());
+  const uint8_t *End =
+      reinterpret_cast<const uint8_t *>((*Buffer)->getBufferEnd());
+  if (End - Cur < (ptrdiff_t)sizeof(Magic) ||
+      memcmp(Cur, Magic, sizeof(Magic)) != 0)
+    return std::nullopt;
+  Cur += sizeof(Magic);
+
+  const char *Error = nullptr;
+  auto Next = [&]() -> uint64_t {
+    if (Error)
+      return 0;
+    unsigned Size;
+    uint64_t Value = decodeULEB128(Cur, &Size, End, &Error);
+    Cur += Size;
+    return Value;
+  };
+
+  if (Next() != Version)
+    return std::nullopt;
+
+  Trace T;
+  uint64_t NumSites = Next();
+  // Every site takes at least three bytes.
+  if (Error || NumSites > (uint64_t)(End - Cur) / 3)
+    return std::nullopt;
+  T.Sites.resize(NumSites);
+  for (Site &S : T.Sites) {
+    S.ID = Next();
+    uint64_t Size = Next();
+    if (Error || (uint64_t)(End - Cur) < Size)
+      return std::nullopt;
+    S.Description.assign(reinterpret_cast<const char *>(Cur), Size);
+    Cur += Size;
+    if (uint64_t Idle = Next())
+      S.Idle = Idle - 1;
+  }
+
+  uint64_t NumDecisions = Next();
+  for (uint64_t I = 0; I < NumDecisions && !Error; ++I) {
+    Decision D;
+    D.PassIndex = Next();
+    D.Site = Next();
+    D.Range = Next();
+    D.Value = Next();
+    if (D.Site >= T.Sites.size())
+      return std::nullopt;
+    T.Decisions.push_back(D);
+  }
+
+  if (Error)
+    return std::nullopt;
+  return T;
+}
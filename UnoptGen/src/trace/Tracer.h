@@ -1,8 +1,100 @@
 #pragma once
 
+#include <cstdint>
+#include <llvm/ADT/DenseMap.h>
+#include <optional>
+#include <source_location>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/*
+ * Record every random decision of the mutating passes as (pass index, site,
+ * value), or replay a recorded trace instead of drawing from the generator.
+ *
+ * Decisions are buffered in memory and written once, when the tracer is
+ * stopped or destroyed at exit. Like the generator, every thread owns its
+ * tracer. When it is off, a decision costs one extra branch.
+ */
+
 class Tracer {
 public:
-    void log();
-    static Tracer* get();
+  struct Decision {
+    // Position of the pass in the mutation pipeline
+    uint32_t PassIndex;
+    // Index into the site table
+    uint32_t Site;
+    // The decision is a value in [0, Range)
+    uint32_t Range;
+    uint32_t Value;
+  };
+
+  // A call of choose() in the source, e.g. "ExprExpander.cpp:20 (expand)".
+  struct Site {
+    uint32_t ID;
+    std::string Description;
+    // The value that leaves the code alone, if the site gates a mutation
+    std::optional<uint32_t> Idle;
+  };
+
+  struct Trace {
+    std::vector<Site> Sites;
+    std::vector<Decision> Decisions;
+  };
+
+  ~Tracer() { stop(); }
+
+  static Tracer *get();
+
+  bool isOn() const { return Recording || Replaying; }
+
+  // Record the following decisions, and write them to Path when stopped.
+  void startRecording(const std::string &Path);
+  // Replay the decisions of the trace at Path. Return false if it is
+  // unreadable.
+  bool startReplaying(const std::string &Path);
+  // Once the replay diverges, gating decisions take their idle value if
+  // IdleAfterDivergence is set, and are drawn from the generator otherwise.
+  void startReplaying(const Trace &T, bool IdleAfterDivergence = false);
+  // Write the recorded trace, if any, and turn the tracer off.
+  void stop();
+
+  void setPassIndex(uint32_t Index) { PassIndex = Index; }
+
+  // Return the recorded value of the next decision when replaying. If the
+  // trace is exhausted or does not match the decision made here, the replay
+  // has diverged; return the idle value or nothing, and the caller draws a
+  // fresh value.
+  std::optional<uint32_t> replay(const std::source_location &Loc,
+                                 uint32_t Range,
+                                 std::optional<uint32_t> Idle);
+  void log(const std::source_location &Loc, uint32_t Range, uint32_t Value,
+           std::optional<uint32_t> Idle);
+
+  const Trace &getRecorded() const { return Recorded; }
+  bool hasDiverged() const { return Diverged; }
+
+  static bool write(const std::string &Path, const Trace &T);
+  static std::optional<Trace> read(const std::string &Path);
+
 private:
+  uint32_t internSite(const std::source_location &Loc,
+                      std::optional<uint32_t> Idle);
+
+  bool Recording = false;
+  bool Replaying = false;
+  bool Diverged = false;
+  bool IdleAfterDivergence = false;
+  uint32_t PassIndex = 0;
+
+  std::string OutputPath;
+  Trace Recorded;
+  // Index in Recorded.Sites of every call site seen, keyed by its file name
+  // pointer, line and column, so that a draw only describes and hashes its
+  // site the first time.
+  llvm::DenseMap<std::tuple<const char *, uint32_t, uint32_t>, uint32_t>
+      SiteIndices;
+
+  Trace Replayed;
+  size_t Cursor = 0;
 };
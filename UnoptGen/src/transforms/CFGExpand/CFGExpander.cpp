@@ -15,7 +15,7 @@ using namespace llvm;
 
 void CFGExpander::run(Function &F) {
   for (auto &BB : F)
-    if (whether())
+    if (whetherToMutate())
       expandBB(&BB);
 }
 
@@ -197,7 +197,7 @@ void expandCondBB(BasicBlock *BB, BranchInst *BI) {
   });
 
   int index = choose(expanders.size());
-  if (whether())
+  if (whetherToMutate())
     expanders[index](BB, BI);
 }
 
@@ -22,7 +22,7 @@ PreservedAnalyses CFGRandomSimplifyPass::run(Function &F,
   auto &TTI = AM.getResult<TargetIRAnalysis>(F);
   // Combine begin from here.
   for (BasicBlock &BB : make_early_inc_range(F)) {
-    if (whether())
+    if (whetherToMutate())
       simplifyCFG(&BB, TTI);
   }
 
@@ -17,7 +17,7 @@ static Value *visitAdd(BinaryOperator *I, IRBuilder<> &Builder) {
   int index = choose(expanders.size());
   auto *LHS = I->getOperand(0);
   auto *RHS = I->getOperand(1);
-  return (whether() ? expanders[index](I, LHS, RHS, Builder) : nullptr);
+  return (whetherToMutate() ? expanders[index](I, LHS, RHS, Builder) : nullptr);
 }
 
 static Value *visitSub(BinaryOperator *I, IRBuilder<> &Builder) {
@@ -34,7 +34,7 @@ static Value *visitSub(BinaryOperator *I, IRBuilder<> &Builder) {
   int index = choose(expanders.size());
   auto *LHS = I->getOperand(0);
   auto *RHS = I->getOperand(1);
-  return (whether() ? expanders[index](I, LHS, RHS, Builder) : nullptr);
+  return (whetherToMutate() ? expanders[index](I, LHS, RHS, Builder) : nullptr);
 }
 
 Value *ExprExpander::expandAddSub(BinaryOperator *I) {
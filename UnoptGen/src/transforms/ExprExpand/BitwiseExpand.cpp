@@ -46,7 +46,7 @@ Value *visitAnd(BinaryOperator *I, IRBuilder<> &Builder) {
   int index = choose(expanders.size());
   auto *LHS = I->getOperand(0);
   auto *RHS = I->getOperand(1);
-  return whether() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
+  return whetherToMutate() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
 }
 
 Value *visitOr(BinaryOperator *I, IRBuilder<> &Builder) {
@@ -89,7 +89,7 @@ Value *visitOr(BinaryOperator *I, IRBuilder<> &Builder) {
   int index = choose(expanders.size());
   auto *LHS = I->getOperand(0);
   auto *RHS = I->getOperand(1);
-  return whether() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
+  return whetherToMutate() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
 }
 
 Value *visitXor(BinaryOperator *I, IRBuilder<> &Builder) {
@@ -109,7 +109,7 @@ Value *visitXor(BinaryOperator *I, IRBuilder<> &Builder) {
   int index = choose(expanders.size());
   auto *LHS = I->getOperand(0);
   auto *RHS = I->getOperand(1);
-  return whether() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
+  return whetherToMutate() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
 }
 
 Value *ExprExpander::expandBitwise(BinaryOperator *I) {
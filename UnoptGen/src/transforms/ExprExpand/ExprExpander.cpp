@@ -17,7 +17,7 @@ void ExprExpander::reorder(Instruction *I) {
     Instruction::BinaryOps Opcode = BinOp->getOpcode();
 
     // Randomly reassciate expressions (A op B) op C or A op (B op C)
-    if (whether() && BinOp->isAssociative() &&
+    if (whetherToMutate() && BinOp->isAssociative() &&
         match(BinOp, m_BinOp(m_CombineAnd(m_BinOp(m_Value(A), m_Value(B)),
                                           m_BinOp(SubI)),
                              m_Value(C))) &&
@@ -32,7 +32,7 @@ void ExprExpander::reorder(Instruction *I) {
       I->replaceAllUsesWith(reordered);
     }
 
-    if (whether() && BinOp->isCommutative())
+    if (whetherToMutate() && BinOp->isCommutative())
       BinOp->swapOperands();
   }
 }
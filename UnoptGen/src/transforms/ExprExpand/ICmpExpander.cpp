@@ -25,5 +25,5 @@ Value *ExprExpander::expandICmp(ICmpInst *I) {
   int index = choose(expanders.size());
   auto *LHS = I->getOperand(0);
   auto *RHS = I->getOperand(1);
-  return whether() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
+  return whetherToMutate() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
 }
@@ -17,7 +17,7 @@ static Value *visitMul(BinaryOperator *I, IRBuilder<> &Builder) {
   int index = choose(expanders.size());
   auto *LHS = I->getOperand(0);
   auto *RHS = I->getOperand(1);
-  return whether() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
+  return whetherToMutate() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
 }
 
 static Value *visitUDiv(BinaryOperator *I, IRBuilder<> &Builder) {
@@ -28,7 +28,7 @@ static Value *visitUDiv(BinaryOperator *I, IRBuilder<> &Builder) {
   int index = choose(expanders.size());
   auto *LHS = I->getOperand(0);
   auto *RHS = I->getOperand(1);
-  return whether() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
+  return whetherToMutate() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
 }
 
 static Value *visitURem(BinaryOperator *I, IRBuilder<> &Builder) {
@@ -42,7 +42,7 @@ static Value *visitURem(BinaryOperator *I, IRBuilder<> &Builder) {
   int index = choose(expanders.size());
   auto *LHS = I->getOperand(0);
   auto *RHS = I->getOperand(1);
-  return whether() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
+  return whetherToMutate() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
 }
 
 Value *ExprExpander::expandMulDivRem(BinaryOperator *I) {
@@ -9,7 +9,7 @@ Value *visitShl(BinaryOperator *I, IRBuilder<> &Builder) {
   int index = choose(expanders.size());
   auto *LHS = I->getOperand(0);
   auto *RHS = I->getOperand(1);
-  return whether() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
+  return whetherToMutate() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
 }
 
 Value *visitAShr(BinaryOperator *I, IRBuilder<> &Builder) {
@@ -27,7 +27,7 @@ Value *visitAShr(BinaryOperator *I, IRBuilder<> &Builder) {
   int index = choose(expanders.size());
   auto *LHS = I->getOperand(0);
   auto *RHS = I->getOperand(1);
-  return whether() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
+  return whetherToMutate() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
 }
 
 Value *visitLShr(BinaryOperator *I, IRBuilder<> &Builder) {
@@ -45,7 +45,7 @@ Value *visitLShr(BinaryOperator *I, IRBuilder<> &Builder) {
   int index = choose(expanders.size());
   auto *LHS = I->getOperand(0);
   auto *RHS = I->getOperand(1);
-  return whether() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
+  return whetherToMutate() ? expanders[index](I, LHS, RHS, Builder) : nullptr;
 }
 
 Value *ExprExpander::expandShift(BinaryOperator *I) {
@@ -0,0 +1,209 @@
+#include "IRNormalizer.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/DebugInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+
+using namespace llvm;
+
+// Instruction metadata that changes what optimizations may do. Everything
+// else, e.g. !dbg, !prof or !annotation, is dropped.
+static const unsigned KeptMetadata[] = {
+    LLVMContext::MD_tbaa,
+    LLVMContext::MD_tbaa_struct,
+    LLVMContext::MD_range,
+    LLVMContext::MD_fpmath,
+    LLVMContext::MD_invariant_load,
+    LLVMContext::MD_alias_scope,
+    LLVMContext::MD_noalias,
+    LLVMContext::MD_nontemporal,
+    LLVMContext::MD_mem_parallel_loop_access,
+    LLVMContext::MD_nonnull,
+    LLVMContext::MD_dereferenceable,
+    LLVMContext::MD_dereferenceable_or_null,
+    LLVMContext::MD_align,
+    LLVMContext::MD_loop,
+    LLVMContext::MD_access_group,
+    LLVMContext::MD_invariant_group,
+    LLVMContext::MD_noundef,
+};
+
+// Named metadata that only records where the module comes from
+static const char *DroppedNamedMetadata[] = {"llvm.ident", "llvm.commandline"};
+
+// Module flags of the debug info
+static const char *DroppedModuleFlags[] = {"Debug Info Version",
+                                           "Dwarf Version", "CodeView"};
+
+static void sortBlocks(Function &F) {
+  SmallPtrSet<BasicBlock *, 32> Reachable;
+  std::vector<BasicBlock *> Order;
+  ReversePostOrderTraversal<Function *> RPOT(&F);
+  for (BasicBlock *BB : RPOT) {
+    Reachable.insert(BB);
+    Order.push_back(BB);
+  }
+  for (BasicBlock &BB : F)
+    if (!Reachable.contains(&BB))
+      Order.push_back(&BB);
+
+  for (BasicBlock *BB : Order)
+    if (BB != &F.back())
+      BB->moveAfter(&F.back());
+}
+
+namespace {
+
+// Where an operand is defined: arguments first, then instructions in layout
+// order, then globals and constants. Constants go last like instcombine puts
+// them.
+struct OperandRank {
+  unsigned Class;
+  uint64_t Number;
+
+  bool operator<(const OperandRank &Other) const {
+    return std::tie(Class, Number) < std::tie(Other.Class, Other.Number);
+  }
+};
+
+class OperandOrder {
+public:
+  OperandOrder(Function &F) {
+    for (Argument &Arg : F.args())
+      Numbers[&Arg] = Numbers.size();
+    for (BasicBlock &BB : F)
+      for (Instruction &I : BB)
+        Numbers[&I] = Numbers.size();
+  }
+
+  OperandRank getRank(Value *V) const {
+    if (auto It = Numbers.find(V); It != Numbers.end())
+      return {0, It->second};
+    if (auto *GV = dyn_cast<GlobalValue>(V))
+      return {1, GlobalNumbers.lookup(GV)};
+    if (isa<Constant>(V))
+      return {2, V->getValueID()};
+    return {3, 0};
+  }
+
+  // Whether the operands of a two-operand instruction are out of order
+  bool shouldSwap(Instruction &I) const {
+    return getRank(I.getOperand(1)) < getRank(I.getOperand(0));
+  }
+
+  void numberGlobals(Module &M) {
+    for (GlobalValue &GV : M.global_values())
+      GlobalNumbers[&GV] = GlobalNumbers.size();
+  }
+
+private:
+  DenseMap<Value *, uint64_t> Numbers;
+  DenseMap<GlobalValue *, uint64_t> GlobalNumbers;
+};
+
+} // namespace
+
+static bool orderOperands(Function &F) {
+  OperandOrder Order(F);
+  if (F.getParent())
+    Order.numberGlobals(*F.getParent());
+
+  bool Changed = false;
+  for (BasicBlock &BB : F)
+    for (Instruction &I : BB) {
+      if (I.getNumOperands() != 2)
+        continue;
+      if (auto *Cmp = dyn_cast<CmpInst>(&I)) {
+        if (Order.shouldSwap(I)) {
+          Cmp->swapOperands();
+          Changed = true;
+        }
+      } else if (isa<BinaryOperator>(I) && I.isCommutative()) {
+        if (Order.shouldSwap(I)) {
+          cast<BinaryOperator>(I).swapOperands();
+          Changed = true;
+        }
+      }
+    }
+  return Changed;
+}
+
+static void renameValues(Function &F) {
+  unsigned ArgNo = 0;
+  for (Argument &Arg : F.args())
+    Arg.setName("a" + Twine(ArgNo++));
+
+  // Clear the names first, or a value may get a suffix because the name it
+  // is given is still held by another one.
+  for (BasicBlock &BB : F) {
+    BB.setName("");
+    for (Instruction &I : BB)
+      I.setName("");
+  }
+
+  unsigned BlockNo = 0, ValueNo = 0;
+  for (BasicBlock &BB : F) {
+    BB.setName("bb" + Twine(BlockNo++));
+    for (Instruction &I : BB)
+      if (!I.getType()->isVoidTy())
+        I.setName("v" + Twine(ValueNo++));
+  }
+}
+
+static void dropMetadata(Function &F) {
+  for (BasicBlock &BB : F)
+    for (Instruction &I : make_early_inc_range(BB)) {
+      if (isa<DbgInfoIntrinsic>(I)) {
+        I.eraseFromParent();
+        continue;
+      }
+      I.dropUnknownNonDebugMetadata(KeptMetadata);
+      I.setDebugLoc(DebugLoc());
+    }
+}
+
+PreservedAnalyses IRNormalizerPass::run(Function &F,
+                                        FunctionAnalysisManager &FAM) {
+  if (F.isDeclaration())
+    return PreservedAnalyses::all();
+
+  dropMetadata(F);
+  sortBlocks(F);
+  orderOperands(F);
+  renameValues(F);
+
+  // Blocks are only moved, the CFG is the same.
+  PreservedAnalyses PA;
+  PA.preserveSet<CFGAnalyses>();
+  return PA;
+}
+
+void llvm::normalizeModule(Module &M) {
+  StripDebugInfo(M);
+  for (const char *Name : DroppedNamedMetadata)
+    if (NamedMDNode *Node = M.getNamedMetadata(Name))
+      M.eraseNamedMetadata(Node);
+
+  if (NamedMDNode *Flags = M.getModuleFlagsMetadata()) {
+    SmallVector<Module::ModuleFlagEntry, 8> Entries;
+    M.getModuleFlagsMetadata(Entries);
+    Flags->clearOperands();
+    for (const Module::ModuleFlagEntry &Entry : Entries)
+      if (!is_contained(DroppedModuleFlags, Entry.Key->getString()))
+        M.addModuleFlag(Entry.Behavior, Entry.Key->getString(), Entry.Val);
+    if (!Flags->getNumOperands())
+      M.eraseNamedMetadata(Flags);
+  }
+
+  FunctionAnalysisManager FAM;
+  IRNormalizerPass Normalizer;
+  for (Function &F : M)
+    Normalizer.run(F, FAM);
+}
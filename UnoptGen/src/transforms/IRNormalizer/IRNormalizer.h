@@ -0,0 +1,26 @@
+#pragma once
+
+#include "llvm/IR/PassManager.h"
+
+namespace llvm {
+
+class Function;
+class Module;
+
+/// Rewrite a function into a canonical form, so that structurally equivalent
+/// functions print, and hash, identically:
+/// - blocks are laid out in reverse post-order, unreachable ones last;
+/// - operands of commutative instructions and comparisons are ordered by
+///   where they are defined, constants last;
+/// - arguments, blocks and values are renamed in that order;
+/// - metadata not affecting the semantics, like debug locations, is dropped.
+class IRNormalizerPass : public PassInfoMixin<IRNormalizerPass> {
+public:
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &FAM);
+};
+
+/// Normalize every function of M, and strip its debug info and the module
+/// metadata irrelevant to optimization.
+void normalizeModule(Module &M);
+
+} // end namespace llvm
@@ -27,7 +27,7 @@ static void randomCombine(Function &F) {
     for (auto &Inst : BB) {
       auto *I = &Inst;
 
-      if (whether()) {
+      if (whetherToMutate()) {
         SimplifyQuery Q(F.getParent()->getDataLayout(), I);
         if (Value *V = simplifyInstruction(I, Q))
           I->replaceAllUsesWith(V);
@@ -0,0 +1,12 @@
+#include "MutationSites.h"
+#include "utils/Random.h"
+
+using namespace llvm;
+
+std::vector<unsigned> MutationSites::samplePlan() const {
+  std::vector<unsigned> Plan;
+  for (unsigned I = 0; I < getNumSites(); ++I)
+    if (whetherToMutate())
+      Plan.push_back(I);
+  return Plan;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Transforms/Utils/ValueMapper.h>
+#include <vector>
+
+namespace llvm {
+
+/*
+ * Two-phase form of a random pass. The pass first enumerates the sites it may
+ * mutate, with the analyses of every function computed once, and then applies
+ * a plan, a subset of the sites, to a clone without any analysis. Many
+ * mutants come out of one enumeration.
+ *
+ * Only the sites of passes whose every subset is legal on its own are
+ * enumerated this way; a pass whose decisions depend on the earlier ones is
+ * run whole instead.
+ */
+
+class MutationSites {
+public:
+  virtual ~MutationSites() = default;
+
+  // Enumerate the sites of F. F may be canonicalized first, as the pass
+  // would, but is not mutated.
+  virtual void enumerate(Function &F, FunctionAnalysisManager &FAM) = 0;
+  virtual unsigned getNumSites() const = 0;
+
+  // Apply the sites of Plan, in increasing order, to a clone of the
+  // enumerated functions whose values VMap maps.
+  virtual void apply(ArrayRef<unsigned> Plan, ValueToValueMapTy &VMap) = 0;
+
+  // Draw every site with whetherToMutate(), like the pass draws its
+  // decisions.
+  std::vector<unsigned> samplePlan() const;
+};
+
+} // namespace llvm
@@ -1159,7 +1159,7 @@ static bool runImpl(Function &F, LazyValueInfo *LVI, DominatorTree *DT,
     bool BBChanged = false;
     for (Instruction &II : llvm::make_early_inc_range(*BB)) {
       // NOTE: Random instrumentation
-      if (whether())
+      if (whetherToSkip())
         continue;
       switch (II.getOpcode()) {
       case Instruction::Select:
@@ -2098,10 +2098,14 @@ struct DSEState {
   }
 };
 
+// If Sites is given, only collect the stores killed completely by a later
+// store or by the end of their object into it, without changing F. Each of
+// them can be removed on its own.
 static bool eliminateDeadStores(Function &F, AliasAnalysis &AA, MemorySSA &MSSA,
                                 DominatorTree &DT, PostDominatorTree &PDT,
                                 const TargetLibraryInfo &TLI,
-                                const LoopInfo &LI) {
+                                const LoopInfo &LI,
+                                SetVector<Instruction *> *Sites = nullptr) {
   bool MadeChange = false;
 
   DSEState State(F, AA, MSSA, DT, PDT, TLI, LI);
@@ -2112,7 +2116,7 @@ static bool eliminateDeadStores(Function &F, AliasAnalysis &AA, MemorySSA &MSSA,
       continue;
 
     // NOTE: Random instrumentation
-    if (whether())
+    if (!Sites && whetherToSkip())
       continue;
 
     Instruction *KillingI = KillingDef->getMemoryInst();
@@ -2193,6 +2197,11 @@ static bool eliminateDeadStores(Function &F, AliasAnalysis &AA, MemorySSA &MSSA,
         const Value *DeadUndObj = getUnderlyingObject(DeadLoc.Ptr);
         if (KillingUndObj != DeadUndObj)
           continue;
+        if (Sites) {
+          if (DeadI->use_empty())
+            Sites->insert(DeadI);
+          continue;
+        }
         LLVM_DEBUG(dbgs() << "DSE: Remove Dead Store:\n  DEAD: " << *DeadI
                           << "\n  KILLER: " << *KillingI << '\n');
         State.deleteDeadInstruction(DeadI);
@@ -2213,7 +2222,8 @@ static bool eliminateDeadStores(Function &F, AliasAnalysis &AA, MemorySSA &MSSA,
                                   DeadOffset, DeadI, IOL);
         }
 
-        if (EnablePartialStoreMerging && OR == OW_PartialEarlierWithFullLater) {
+        if (!Sites && EnablePartialStoreMerging &&
+            OR == OW_PartialEarlierWithFullLater) {
           auto *DeadSI = dyn_cast<StoreInst>(DeadI);
           auto *KillingSI = dyn_cast<StoreInst>(KillingI);
           // We are re-using tryToMergePartialOverlappingStores, which requires
@@ -2241,7 +2251,10 @@ static bool eliminateDeadStores(Function &F, AliasAnalysis &AA, MemorySSA &MSSA,
           }
         }
 
-        if (OR == OW_Complete) {
+        if (OR == OW_Complete && Sites) {
+          if (DeadI->use_empty())
+            Sites->insert(DeadI);
+        } else if (OR == OW_Complete) {
           LLVM_DEBUG(dbgs() << "DSE: Remove Dead Store:\n  DEAD: " << *DeadI
                             << "\n  KILLER: " << *KillingI << '\n');
           State.deleteDeadInstruction(DeadI);
@@ -2251,6 +2264,9 @@ static bool eliminateDeadStores(Function &F, AliasAnalysis &AA, MemorySSA &MSSA,
       }
     }
 
+    if (Sites)
+      continue;
+
     // Check if the store is a no-op.
     if (!Shortend && State.storeIsNoop(KillingDef, KillingUndObj)) {
       LLVM_DEBUG(dbgs() << "DSE: Remove No-Op Store:\n  DEAD: " << *KillingI
@@ -2271,6 +2287,9 @@ static bool eliminateDeadStores(Function &F, AliasAnalysis &AA, MemorySSA &MSSA,
     }
   }
 
+  if (Sites)
+    return false;
+
   if (EnablePartialOverwriteTracking)
     for (auto &KV : State.IOLs)
       MadeChange |= State.removePartiallyOverlappedStores(KV.second);
@@ -2315,3 +2334,27 @@ PreservedAnalyses RandomDSEPass::run(Function &F, FunctionAnalysisManager &AM) {
   PA.preserve<LoopAnalysis>();
   return PA;
 }
+
+void RandomDSESites::enumerate(Function &F, FunctionAnalysisManager &AM) {
+  SetVector<Instruction *> Sites;
+  eliminateDeadStores(F, AM.getResult<AAManager>(F),
+                      AM.getResult<MemorySSAAnalysis>(F).getMSSA(),
+                      AM.getResult<DominatorTreeAnalysis>(F),
+                      AM.getResult<PostDominatorTreeAnalysis>(F),
+                      AM.getResult<TargetLibraryAnalysis>(F),
+                      AM.getResult<LoopAnalysis>(F), &Sites);
+  DeadStores.insert(DeadStores.end(), Sites.begin(), Sites.end());
+}
+
+void RandomDSESites::apply(ArrayRef<unsigned> Plan, ValueToValueMapTy &VMap) {
+  for (unsigned Site : Plan) {
+    auto *DeadI = cast<Instruction>(VMap[DeadStores[Site]]);
+    SmallVector<WeakTrackingVH, 4> Operands;
+    for (Value *Op : DeadI->operands())
+      if (isa<Instruction>(Op))
+        Operands.push_back(Op);
+    salvageDebugInfo(*DeadI);
+    DeadI->eraseFromParent();
+    RecursivelyDeleteTriviallyDeadInstructionsPermissive(Operands);
+  }
+}
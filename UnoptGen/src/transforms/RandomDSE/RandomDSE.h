@@ -1,6 +1,8 @@
 #pragma once
 
 #include "llvm/IR/PassManager.h"
+#include "transforms/MutationSites.h"
+#include <vector>
 
 namespace llvm {
 
@@ -13,4 +15,17 @@ public:
   PreservedAnalyses run(Function &F, FunctionAnalysisManager &FAM);
 };
 
+/// The sites are the stores the pass may remove on its own: those completely
+/// overwritten by a later store, or ended by the end of their object, with
+/// no read in between.
+class RandomDSESites : public MutationSites {
+public:
+  void enumerate(Function &F, FunctionAnalysisManager &FAM) override;
+  unsigned getNumSites() const override { return DeadStores.size(); }
+  void apply(ArrayRef<unsigned> Plan, ValueToValueMapTy &VMap) override;
+
+private:
+  std::vector<Instruction *> DeadStores;
+};
+
 } // end namespace llvm
@@ -421,7 +421,7 @@ bool UnoptGen::sinkRegion(DomTreeNode *N, AAResults *AA, LoopInfo *LI,
       Instruction &I = *--II;
 
       // NOTE: Random instrumentation
-      if (whether())
+      if (whetherToSkip())
         continue;
       // The instruction is not used in the loop if it is dead.  In this case,
       // we just delete it instead of sinking it.
@@ -755,7 +755,7 @@ bool UnoptGen::hoistRegion(DomTreeNode *N, AAResults *AA, LoopInfo *LI,
       // and we have accurately duplicated the control flow from the loop header
       // to that block.
       // NOTE: Random instrumentation
-      if (whether())
+      if (whetherToSkip())
         continue;
       if (CurLoop->hasLoopInvariantOperands(&I) &&
           canSinkOrHoistInst(I, AA, DT, CurLoop, MSSAU, true, Flags, ORE) &&
@@ -1948,7 +1948,7 @@ collectPromotionCandidates(MemorySSA *MSSA, AliasAnalysis *AA, Loop *L) {
 
   auto IsPotentiallyPromotable = [L](const Instruction *I) {
     // NOTE: Random instrumentation
-    if (whether())
+    if (whetherToSkip())
       return false;
     if (const auto *SI = dyn_cast<StoreInst>(I))
       return L->isLoopInvariant(SI->getPointerOperand());
@@ -257,7 +257,7 @@ static bool sinkLoopInvariantInstructions(Loop &L, AAResults &AA, LoopInfo &LI,
   int i = 0;
   for (BasicBlock *B : L.blocks())
     // NOTE: Random Instrumentation
-    if (whether()) {
+    if (whetherToMutate()) {
       ColdLoopBBs.push_back(B);
       LoopBlockNumber[B] = ++i;
     }
@@ -274,8 +274,9 @@ static bool sinkLoopInvariantInstructions(Loop &L, AAResults &AA, LoopInfo &LI,
     if (!canSinkOrHoistInst(I, &AA, &DT, &L, MSSAU, false, LICMFlags))
       continue;
     // NOTE: Random Instrumentation
-    if (whether() && sinkInstruction(L, I, ColdLoopBBs, LoopBlockNumber, LI, DT,
-                                     BFI, &MSSAU)) {
+    if (whetherToMutate() && sinkInstruction(L, I, ColdLoopBBs,
+                                             LoopBlockNumber, LI, DT, BFI,
+                                             &MSSAU)) {
       Changed = true;
       if (SE)
         SE->forgetBlockAndLoopDispositions(&I);
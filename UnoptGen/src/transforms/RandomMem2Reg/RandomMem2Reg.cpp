@@ -33,7 +33,7 @@ static bool promoteMemoryToRegister(Function &F, DominatorTree &DT,
     // the entry node
     for (BasicBlock::iterator I = BB.begin(), E = --BB.end(); I != E; ++I)
       if (AllocaInst *AI = dyn_cast<AllocaInst>(I)) // Is it an alloca?
-        if (whether() && isAllocaPromotable(AI))
+        if (whetherToMutate() && isAllocaPromotable(AI))
           Allocas.push_back(AI);
 
     if (Allocas.empty())
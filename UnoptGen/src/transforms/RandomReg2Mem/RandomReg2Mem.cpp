@@ -24,7 +24,9 @@ static bool valueEscapes(const Instruction &Inst) {
   return false;
 }
 
-static bool runPass(Function &F) {
+// The "reg2mem alloca point" new allocas go before, at the end of the allocas
+// of the entry block
+static Instruction *createAllocaPoint(Function &F) {
   // Insert all new allocas into entry block.
   BasicBlock *BBEntry = &F.getEntryBlock();
   assert(pred_empty(BBEntry) &&
@@ -37,21 +39,51 @@ static bool runPass(Function &F) {
   while (isa<AllocaInst>(I))
     ++I;
 
-  CastInst *AllocaInsertionPoint = new BitCastInst(
+  return new BitCastInst(
       Constant::getNullValue(Type::getInt32Ty(F.getContext())),
       Type::getInt32Ty(F.getContext()), "reg2mem alloca point", &*I);
+}
 
-  // Find the escaped instructions. But don't create stack slots for
-  // allocas in entry block.
+// The escaped instructions, without the allocas in the entry block, then the
+// phis, in the order the pass demotes them
+static std::vector<Instruction *> collectDemotable(Function &F) {
+  BasicBlock *BBEntry = &F.getEntryBlock();
   std::list<Instruction *> WorkList;
   for (Instruction &I : instructions(F))
     if (!(isa<AllocaInst>(I) && I.getParent() == BBEntry) && valueEscapes(I))
       WorkList.push_front(&I);
 
-  // Demote escaped instructions
+  std::list<Instruction *> Phis;
+  for (BasicBlock &BB : F)
+    for (auto &Phi : BB.phis())
+      Phis.push_front(&Phi);
+
+  std::vector<Instruction *> Demotable(WorkList.begin(), WorkList.end());
+  Demotable.insert(Demotable.end(), Phis.begin(), Phis.end());
+  return Demotable;
+}
+
+static void demote(Instruction *I, Instruction *AllocaPoint, bool IsPhi) {
+  if (IsPhi)
+    DemotePHIToStack(cast<PHINode>(I), AllocaPoint->getIterator());
+  else
+    DemoteRegToStack(*I, false, AllocaPoint->getIterator());
+}
+
+static bool runPass(Function &F) {
+  Instruction *AllocaInsertionPoint = createAllocaPoint(F);
+
+  // Demote escaped instructions, then phi nodes. The phis are collected after
+  // the escaped instructions are demoted.
+  std::list<Instruction *> WorkList;
+  BasicBlock *BBEntry = &F.getEntryBlock();
+  for (Instruction &I : instructions(F))
+    if (!(isa<AllocaInst>(I) && I.getParent() == BBEntry) && valueEscapes(I))
+      WorkList.push_front(&I);
+
   for (Instruction *I : WorkList)
-    if (whether())
-      DemoteRegToStack(*I, false, AllocaInsertionPoint->getIterator());
+    if (whetherToMutate())
+      demote(I, AllocaInsertionPoint, /*IsPhi=*/false);
 
   WorkList.clear();
 
@@ -62,8 +94,8 @@ static bool runPass(Function &F) {
 
   // Demote phi nodes
   for (Instruction *I : WorkList)
-    if (whether())
-      DemotePHIToStack(cast<PHINode>(I), AllocaInsertionPoint->getIterator());
+    if (whetherToMutate())
+      demote(I, AllocaInsertionPoint, /*IsPhi=*/true);
 
   return true;
 }
@@ -81,3 +113,29 @@ PreservedAnalyses RandomRegToMemPass::run(Function &F,
   PA.preserve<LoopAnalysis>();
   return PA;
 }
+
+void RandomRegToMemSites::enumerate(Function &F, FunctionAnalysisManager &AM) {
+  auto *DT = &AM.getResult<DominatorTreeAnalysis>(F);
+  auto *LI = &AM.getResult<LoopAnalysis>(F);
+  if (SplitAllCriticalEdges(F, CriticalEdgeSplittingOptions(DT, LI))) {
+    PreservedAnalyses PA;
+    PA.preserve<DominatorTreeAnalysis>();
+    PA.preserve<LoopAnalysis>();
+    AM.invalidate(F, PA);
+  }
+
+  for (Instruction *I : collectDemotable(F))
+    Sites.push_back({I, isa<PHINode>(I)});
+}
+
+void RandomRegToMemSites::apply(ArrayRef<unsigned> Plan,
+                                ValueToValueMapTy &VMap) {
+  DenseMap<Function *, Instruction *> AllocaPoints;
+  for (unsigned Site : Plan) {
+    auto *I = cast<Instruction>(VMap[Sites[Site].first]);
+    Instruction *&AllocaPoint = AllocaPoints[I->getFunction()];
+    if (!AllocaPoint)
+      AllocaPoint = createAllocaPoint(*I->getFunction());
+    demote(I, AllocaPoint, Sites[Site].second);
+  }
+}
@@ -3,6 +3,9 @@
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Instruction.h>
 #include <llvm/IR/PassManager.h>
+#include "transforms/MutationSites.h"
+#include <utility>
+#include <vector>
 
 #define DEBUG_TYPE "random-reg2mem"
 
@@ -15,4 +18,18 @@ public:
   PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
 };
 
+// The sites are the escaped instructions and the phis, demoted to the stack
+// in any subset. Critical edges are split when enumerating, like the pass
+// does.
+class RandomRegToMemSites : public MutationSites {
+public:
+  void enumerate(Function &F, FunctionAnalysisManager &AM) override;
+  unsigned getNumSites() const override { return Sites.size(); }
+  void apply(ArrayRef<unsigned> Plan, ValueToValueMapTy &VMap) override;
+
+private:
+  // Whether every instruction is a phi demoted as one
+  std::vector<std::pair<Instruction *, bool>> Sites;
+};
+
 } // namespace llvm
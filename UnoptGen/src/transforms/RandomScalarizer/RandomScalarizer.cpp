@@ -404,7 +404,7 @@ bool ScalarizerVisitor::visit(Function &F) {
       Instruction *I = &*II;
       bool Done = false;
       // NOTE: Random instrumentation
-      if (whether())
+      if (whetherToMutate())
         Done = InstVisitor::visit(I);
       ++II;
       if (Done && I->getType()->isVoidTy())
@@ -134,7 +134,7 @@ static bool SinkInstruction(Instruction *Inst,
     // be beneficial. Find an ancestor.
     // NOTE: Random instrumentation
     while (SuccToSinkTo != BB &&
-           !IsAcceptableTarget(Inst, SuccToSinkTo, DT, LI) && whether())
+           !IsAcceptableTarget(Inst, SuccToSinkTo, DT, LI) && whetherToSkip())
       SuccToSinkTo = DT.getNode(SuccToSinkTo)->getIDom()->getBlock();
     if (SuccToSinkTo == BB)
       SuccToSinkTo = nullptr;
@@ -181,7 +181,7 @@ static bool ProcessBlock(BasicBlock &BB, DominatorTree &DT, LoopInfo &LI,
       continue;
 
     //  NOTE: Random instrumentation
-    if (whether() && SinkInstruction(Inst, Stores, DT, LI, AA)) {
+    if (whetherToMutate() && SinkInstruction(Inst, Stores, DT, LI, AA)) {
       MadeChange = true;
     }
 
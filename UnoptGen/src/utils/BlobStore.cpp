@@ -0,0 +1,213 @@
+#include "BlobStore.h"
+#include <llvm/ADT/ScopeExit.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Compression.h>
+#include <llvm/Support/Endian.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+using namespace llvm;
+
+static cl::opt<std::string>
+    BlobStoreDir("blob-store",
+                 cl::desc("Directory of the blob store, for blob:<name> paths"),
+                 cl::init(""));
+
+// Segments are rolled over once they reach this size.
+static const uint64_t SegmentSize = 1ULL << 30;
+
+// An index record: the name (16 bytes), the segment (4), the offset (8), the
+// stored size (4), the raw size (4) and whether it is compressed (1), all
+// little-endian.
+static const unsigned NameSize = 16;
+static const unsigned RecordSize = NameSize + 4 + 8 + 4 + 4 + 1;
+
+std::unique_ptr<BlobStore> BlobStore::open(StringRef Dir) {
+  if (sys::fs::create_directories(Dir))
+    return nullptr;
+  std::unique_ptr<BlobStore> Store(new BlobStore(Dir));
+  Store->refreshIndex();
+  return Store;
+}
+
+BlobStore *BlobStore::getDefault() {
+  static std::unique_ptr<BlobStore> Default = []() {
+    std::string Dir = BlobStoreDir;
+    if (Dir.empty())
+      Dir = sys::Process::GetEnv("MO_BLOB_STORE").value_or("");
+    return Dir.empty() ? nullptr : open(Dir);
+  }();
+  return Default.get();
+}
+
+std::string BlobStore::getPath(StringRef Name) const {
+  SmallString<128> Path(Dir);
+  sys::path::append(Path, Name);
+  return std::string(Path);
+}
+
+std::string BlobStore::getSegmentPath(uint32_t Segment) const {
+  return getPath("segment-" + std::to_string(Segment));
+}
+
+void BlobStore::refreshIndex() {
+  uint64_t Size;
+  if (sys::fs::file_size(getPath("index"), Size) || Size <= IndexSize)
+    return;
+
+  // A record being written by another process is read next time.
+  uint64_t NumRecords = (Size - IndexSize) / RecordSize;
+  auto Buffer =
+      MemoryBuffer::getFileSlice(getPath("index"), NumRecords * RecordSize,
+                                 IndexSize, /*IsVolatile=*/true);
+  if (!Buffer)
+    return;
+
+  StringRef Data = (*Buffer)->getBuffer();
+  for (; Data.size() >= RecordSize; Data = Data.drop_front(RecordSize)) {
+    const char *P = Data.data() + NameSize;
+    Location Loc;
+    Loc.Segment = support::endian::read32le(P);
+    Loc.Offset = support::endian::read64le(P + 4);
+    Loc.Size = support::endian::read32le(P + 12);
+    Loc.RawSize = support::endian::read32le(P + 16);
+    Loc.Compressed = P[20];
+    Index[toHex(Data.take_front(NameSize), /*LowerCase=*/true)] = Loc;
+    LastSegment = std::max(LastSegment, Loc.Segment);
+    IndexSize += RecordSize;
+  }
+}
+
+bool BlobStore::contains(StringRef Name) {
+  std::lock_guard<std::mutex> Guard(Lock);
+  if (!Index.contains(Name))
+    refreshIndex();
+  return Index.contains(Name);
+}
+
+std::optional<std::string> BlobStore::put(StringRef Data) {
+  XXH128_hash_t Hash = xxh3_128bits(arrayRefFromStringRef(Data));
+  char RawName[NameSize];
+  support::endian::write64le(RawName, Hash.high64);
+  support::endian::write64le(RawName + 8, Hash.low64);
+  std::string Name = toHex(StringRef(RawName, NameSize), /*LowerCase=*/true);
+
+  std::lock_guard<std::mutex> Guard(Lock);
+  refreshIndex();
+  if (Index.contains(Name))
+    return Name;
+
+  Location Loc;
+  SmallVector<uint8_t, 0> Compressed;
+  Loc.Compressed = compression::zstd::isAvailable();
+  if (Loc.Compressed)
+    compression::zstd::compress(arrayRefFromStringRef(Data), Compressed);
+  StringRef Stored = Loc.Compressed ? toStringRef(Compressed) : Data;
+  Loc.Size = Stored.size();
+  Loc.RawSize = Data.size();
+
+  int LockFD;
+  if (sys::fs::openFileForWrite(getPath("lock"), LockFD,
+                                sys::fs::CD_OpenAlways))
+    return std::nullopt;
+  auto CloseLock = make_scope_exit(
+      [&] { sys::Process::SafelyCloseFileDescriptor(LockFD); });
+  if (sys::fs::lockFile(LockFD))
+    return std::nullopt;
+  auto Unlock = make_scope_exit([&] { sys::fs::unlockFile(LockFD); });
+
+  // Another process may have stored it meanwhile.
+  refreshIndex();
+  if (Index.contains(Name))
+    return Name;
+
+  uint64_t Offset = 0;
+  Loc.Segment = LastSegment;
+  if (!sys::fs::file_size(getSegmentPath(Loc.Segment), Offset) &&
+      Offset + Stored.size() > SegmentSize && Offset > 0) {
+    ++Loc.Segment;
+    Offset = 0;
+  }
+  Loc.Offset = Offset;
+
+  std::error_code EC;
+  {
+    raw_fd_ostream Segment(getSegmentPath(Loc.Segment), EC,
+                           sys::fs::OF_Append);
+    if (EC)
+      return std::nullopt;
+    Segment << Stored;
+  }
+
+  // A crash or a short write may have left part of a record at the end of
+  // the index. Drop it, or every record appended after it would be read at
+  // the wrong offset.
+  uint64_t IndexFileSize;
+  if (!sys::fs::file_size(getPath("index"), IndexFileSize) &&
+      IndexFileSize % RecordSize) {
+    int IndexFD;
+    if (sys::fs::openFileForWrite(getPath("index"), IndexFD,
+                                  sys::fs::CD_OpenExisting))
+      return std::nullopt;
+    EC = sys::fs::resize_file(IndexFD,
+                              IndexFileSize - IndexFileSize % RecordSize);
+    sys::Process::SafelyCloseFileDescriptor(IndexFD);
+    if (EC)
+      return std::nullopt;
+  }
+
+  // The record is appended only once the data is complete, so that a crash
+  // leaves at most some unreachable bytes in the segment and part of a
+  // record, dropped by the next put.
+  char Record[RecordSize];
+  memcpy(Record, RawName, NameSize);
+  char *P = Record + NameSize;
+  support::endian::write32le(P, Loc.Segment);
+  support::endian::write64le(P + 4, Loc.Offset);
+  support::endian::write32le(P + 12, Loc.Size);
+  support::endian::write32le(P + 16, Loc.RawSize);
+  P[20] = Loc.Compressed;
+  {
+    raw_fd_ostream IndexFile(getPath("index"), EC, sys::fs::OF_Append);
+    if (EC)
+      return std::nullopt;
+    IndexFile.write(Record, RecordSize);
+  }
+
+  refreshIndex();
+  return Name;
+}
+
+std::optional<std::string> BlobStore::get(StringRef Name) {
+  Location Loc;
+  {
+    std::lock_guard<std::mutex> Guard(Lock);
+    if (!Index.contains(Name))
+      refreshIndex();
+    auto It = Index.find(Name);
+    if (It == Index.end())
+      return std::nullopt;
+    Loc = It->second;
+  }
+
+  auto Buffer =
+      MemoryBuffer::getFileSlice(getSegmentPath(Loc.Segment), Loc.Size,
+                                 Loc.Offset, /*IsVolatile=*/true);
+  if (!Buffer || (*Buffer)->getBufferSize() != Loc.Size)
+    return std::nullopt;
+  if (!Loc.Compressed)
+    return (*Buffer)->getBuffer().str();
+
+  SmallVector<uint8_t, 0> Raw;
+  if (Error E = compression::zstd::decompress(
+          arrayRefFromStringRef((*Buffer)->getBuffer()), Raw, Loc.RawSize)) {
+    consumeError(std::move(E));
+    return std::nullopt;
+  }
+  return toStringRef(Raw).str();
+}
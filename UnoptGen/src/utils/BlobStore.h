@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace llvm {
+
+/*
+ * Content-addressed store of campaign artifacts. A blob is named by the
+ * XXH3-128 of its content, compressed with zstd and appended to a large
+ * segment file, and an append-only index maps names to their place in the
+ * segments. Equal files, like the same original found many times, are stored
+ * once.
+ *
+ * Writers in several processes are serialized by a lock file; readers only
+ * pick up the index records appended since they last looked.
+ */
+
+class BlobStore {
+public:
+  // Open the store in Dir, creating it if needed. Return nullptr on failure.
+  static std::unique_ptr<BlobStore> open(StringRef Dir);
+
+  // The store given by -blob-store or $MO_BLOB_STORE, if any.
+  static BlobStore *getDefault();
+
+  // Store Data and return its name. Storing existing content is free.
+  std::optional<std::string> put(StringRef Data);
+  std::optional<std::string> get(StringRef Name);
+  bool contains(StringRef Name);
+
+private:
+  struct Location {
+    uint32_t Segment;
+    uint64_t Offset;
+    uint32_t Size;
+    uint32_t RawSize;
+    bool Compressed;
+  };
+
+  BlobStore(StringRef Dir) : Dir(Dir) {}
+
+  // Read the index records appended since the last refresh.
+  void refreshIndex();
+  std::string getPath(StringRef Name) const;
+  std::string getSegmentPath(uint32_t Segment) const;
+
+  std::string Dir;
+  StringMap<Location> Index;
+  // Bytes of the index file already read
+  uint64_t IndexSize = 0;
+  uint32_t LastSegment = 0;
+  // Threads of one process share the store.
+  std::mutex Lock;
+};
+
+} // namespace llvm
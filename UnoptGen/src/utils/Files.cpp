@@ -1,23 +1,123 @@
 #include "Files.h"
+#include "BlobStore.h"
 #include <fstream>
 #include <iostream>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
 #include <random>
+#include <sstream>
+
+using namespace llvm;
+
+static const StringRef BlobPrefix = "blob:";
+// Larger files can't be references to blobs.
+static const uint64_t MaxReferenceSize = 64;
+
+std::optional<std::string> ReadBlobReference(const std::string &Path) {
+  uint64_t Size;
+  if (sys::fs::file_size(Path, Size) || Size > MaxReferenceSize)
+    return std::nullopt;
+  auto Buffer = MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return std::nullopt;
+  StringRef Ref = (*Buffer)->getBuffer().rtrim("\n");
+  if (!Ref.starts_with(BlobPrefix) ||
+      Ref.find_first_of(" \n") != StringRef::npos)
+    return std::nullopt;
+  return Ref.str();
+}
+
+std::optional<std::string> ReadFile(const std::string &Path) {
+  StringRef Name(Path);
+  if (Name.consume_front(BlobPrefix)) {
+    BlobStore *Store = BlobStore::getDefault();
+    return Store ? Store->get(Name) : std::nullopt;
+  }
+
+  if (auto Ref = ReadBlobReference(Path))
+    return ReadFile(*Ref);
+
+  auto Buffer = MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return std::nullopt;
+  return (*Buffer)->getBuffer().str();
+}
+
+std::optional<std::string> WriteFile(const std::string &Path,
+                                     StringRef Data) {
+  if (Path == BlobPrefix) {
+    BlobStore *Store = BlobStore::getDefault();
+    if (!Store)
+      return std::nullopt;
+    if (auto Name = Store->put(Data))
+      return BlobPrefix.str() + *Name;
+    return std::nullopt;
+  }
+
+  std::error_code EC;
+  raw_fd_ostream Out(Path, EC, sys::fs::OF_Text);
+  if (EC)
+    return std::nullopt;
+  Out << Data;
+  return Path;
+}
+
+std::unique_ptr<Module> ParseIRFile(const std::string &Path,
+                                    SMDiagnostic &Diag,
+                                    LLVMContext &Context) {
+  if (!StringRef(Path).starts_with(BlobPrefix) && !ReadBlobReference(Path))
+    return parseIRFile(Path, Diag, Context);
+
+  auto Data = ReadFile(Path);
+  if (!Data) {
+    Diag = SMDiagnostic(Path, SourceMgr::DK_Error, "No such blob");
+    return nullptr;
+  }
+  return parseIR(MemoryBufferRef(*Data, Path), Diag, Context);
+}
+
+std::optional<std::string> WriteModule(const Module &M,
+                                       const std::string &Path) {
+  // TODO: Support bitcode writer
+  std::string Text;
+  raw_string_ostream OS(Text);
+  M.print(OS, nullptr);
+  OS.flush();
+  return WriteFile(Path, Text);
+}
+
+std::string WriteBitcode(const Module &M) {
+  std::string Bitcode;
+  raw_string_ostream OS(Bitcode);
+  WriteBitcodeToFile(M, OS);
+  OS.flush();
+  return Bitcode;
+}
+
+std::unique_ptr<Module> ParseBitcode(StringRef Bitcode, LLVMContext &Context) {
+  auto Buffer = MemoryBuffer::getMemBuffer(Bitcode, "", false);
+  auto M = parseBitcodeFile(Buffer->getMemBufferRef(), Context);
+  if (!M) {
+    consumeError(M.takeError());
+    return nullptr;
+  }
+  return std::move(*M);
+}
 
 std::vector<std::string> ReadPipeline(const std::string &Path) {
   std::vector<std::string> Ret;
-  std::ifstream In;
-  In.open(Path, std::ios::in);
-  if (In.fail())
+  auto Data = ReadFile(Path);
+  if (!Data)
     return {};
+  std::istringstream In(*Data);
 
-  while (!In.eof()) {
-    std::string Elt;
-    In >> Elt;
+  std::string Elt;
+  while (In >> Elt)
     Ret.push_back(Elt);
-  }
-  Ret.erase(Ret.end());
-
-  In.close();
   return Ret;
 }
 
@@ -39,15 +139,12 @@ int WritePipeline(const std::string &Path,
 
 ulong ReadSeed(const std::string &Path) {
   ulong Ret;
-  std::ifstream In;
-  In.open(Path, std::ios::in);
-  if (In.fail()) {
+  auto Data = ReadFile(Path);
+  if (!Data) {
     std::random_device RD;
     Ret = RD();
   } else
-    In >> Ret;
-
-  In.close();
+    std::istringstream(*Data) >> Ret;
   return Ret;
 }
 
@@ -1,7 +1,35 @@
 #pragma once
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/SourceMgr.h>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
+// Files read and written by the tools. A path of the form "blob:<name>" is a
+// blob of the store given by -blob-store, see BlobStore. A file holding only
+// such a path, like the files of a case packed by moblob, is read as the blob.
+std::optional<std::string> ReadFile(const std::string &Path);
+// The blob path the file at Path holds, if it is a reference to a blob
+std::optional<std::string> ReadBlobReference(const std::string &Path);
+// Write Data to Path. Writing to "blob:" stores a new blob instead. Return the
+// path written, or nothing on failure.
+std::optional<std::string> WriteFile(const std::string &Path,
+                                     llvm::StringRef Data);
+
+std::unique_ptr<llvm::Module> ParseIRFile(const std::string &Path,
+                                          llvm::SMDiagnostic &Diag,
+                                          llvm::LLVMContext &Context);
+// Write M as textual IR, like WriteFile.
+std::optional<std::string> WriteModule(const llvm::Module &M,
+                                       const std::string &Path);
+
+// In-memory bitcode, to move modules between LLVMContexts of threads
+std::string WriteBitcode(const llvm::Module &M);
+std::unique_ptr<llvm::Module> ParseBitcode(llvm::StringRef Bitcode,
+                                           llvm::LLVMContext &Context);
+
 std::vector<std::string> ReadPipeline(const std::string &Path);
 
 int WritePipeline(const std::string &Path, const std::vector<std::string> &Pipeline);
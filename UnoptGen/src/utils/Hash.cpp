@@ -0,0 +1,206 @@
+#include "Hash.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/InlineAsm.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Metadata.h>
+#include <llvm/Support/xxhash.h>
+
+using namespace llvm;
+
+namespace {
+
+// Tags separating the kinds of operands in the token stream.
+enum OperandTag : uint64_t {
+  ConstantTag = 'C',
+  LocalTag = 'L',
+  MetadataTag = 'M',
+  AsmTag = 'A',
+  UnknownTag = '?',
+};
+
+class StructuralHasher {
+public:
+  void add(uint64_t V) { Tokens.push_back(V); }
+  void add(StringRef S) { add(xxHash64(S)); }
+
+  void addAPInt(const APInt &V) {
+    add(V.getBitWidth());
+    for (unsigned i = 0; i < V.getNumWords(); ++i)
+      add(V.getRawData()[i]);
+  }
+
+  void addType(const Type *T) {
+    add(T->getTypeID());
+    if (auto *IT = dyn_cast<IntegerType>(T)) {
+      add(IT->getBitWidth());
+    } else if (auto *PT = dyn_cast<PointerType>(T)) {
+      add(PT->getAddressSpace());
+    } else if (auto *VT = dyn_cast<VectorType>(T)) {
+      add(VT->getElementCount().getKnownMinValue());
+      addType(VT->getElementType());
+    } else if (auto *AT = dyn_cast<ArrayType>(T)) {
+      add(AT->getNumElements());
+      addType(AT->getElementType());
+    } else if (auto *ST = dyn_cast<StructType>(T)) {
+      // Identified structs may be renamed when moved between contexts, so only
+      // the layout matters.
+      add(ST->isPacked());
+      add(ST->isOpaque() ? 0 : ST->getNumElements() + 1);
+      if (!ST->isOpaque())
+        for (Type *Elt : ST->elements())
+          addType(Elt);
+    } else if (auto *FT = dyn_cast<FunctionType>(T)) {
+      add(FT->isVarArg());
+      add(FT->getNumParams());
+      addType(FT->getReturnType());
+      for (Type *Param : FT->params())
+        addType(Param);
+    }
+  }
+
+  void addConstant(const Constant *C) {
+    add(C->getValueID());
+    addType(C->getType());
+
+    if (auto *GV = dyn_cast<GlobalValue>(C)) {
+      add(GV->getName());
+    } else if (auto *CI = dyn_cast<ConstantInt>(C)) {
+      addAPInt(CI->getValue());
+    } else if (auto *CF = dyn_cast<ConstantFP>(C)) {
+      addAPInt(CF->getValueAPF().bitcastToAPInt());
+    } else if (auto *CDS = dyn_cast<ConstantDataSequential>(C)) {
+      add(CDS->getRawDataValues());
+    } else if (auto *BA = dyn_cast<BlockAddress>(C)) {
+      add(BA->getFunction()->getName());
+      add(LocalNumbers.lookup(BA->getBasicBlock()));
+    } else {
+      if (auto *CE = dyn_cast<ConstantExpr>(C)) {
+        add(CE->getOpcode());
+        if (CE->isCompare())
+          add(CE->getPredicate());
+      }
+      for (const Use &Op : C->operands())
+        addConstant(cast<Constant>(Op.get()));
+    }
+  }
+
+  void addOperand(const Value *V) {
+    if (auto *C = dyn_cast<Constant>(V)) {
+      add(ConstantTag);
+      addConstant(C);
+    } else if (auto It = LocalNumbers.find(V); It != LocalNumbers.end()) {
+      add(LocalTag);
+      add(It->second);
+    } else if (isa<MetadataAsValue>(V)) {
+      add(MetadataTag);
+    } else if (auto *IA = dyn_cast<InlineAsm>(V)) {
+      add(AsmTag);
+      add(IA->getAsmString());
+      add(IA->getConstraintString());
+    } else {
+      add(UnknownTag);
+    }
+  }
+
+  void addInstruction(const Instruction &I) {
+    add(I.getOpcode());
+    addType(I.getType());
+    // Flags like nuw/nsw/exact/fast-math.
+    add(I.getRawSubclassOptionalData());
+
+    if (auto *Cmp = dyn_cast<CmpInst>(&I))
+      add(Cmp->getPredicate());
+    else if (auto *AI = dyn_cast<AllocaInst>(&I))
+      addType(AI->getAllocatedType());
+    else if (auto *GEP = dyn_cast<GetElementPtrInst>(&I))
+      addType(GEP->getSourceElementType());
+    else if (auto *LI = dyn_cast<LoadInst>(&I)) {
+      add(LI->isVolatile());
+      add(static_cast<uint64_t>(LI->getOrdering()));
+    } else if (auto *SI = dyn_cast<StoreInst>(&I)) {
+      add(SI->isVolatile());
+      add(static_cast<uint64_t>(SI->getOrdering()));
+    } else if (auto *SVI = dyn_cast<ShuffleVectorInst>(&I)) {
+      for (int Elt : SVI->getShuffleMask())
+        add(static_cast<uint64_t>(Elt));
+    } else if (auto *EVI = dyn_cast<ExtractValueInst>(&I)) {
+      for (unsigned Idx : EVI->indices())
+        add(Idx);
+    } else if (auto *IVI = dyn_cast<InsertValueInst>(&I)) {
+      for (unsigned Idx : IVI->indices())
+        add(Idx);
+    } else if (auto *PN = dyn_cast<PHINode>(&I)) {
+      for (const BasicBlock *BB : PN->blocks())
+        add(LocalNumbers.lookup(BB));
+    }
+
+    add(I.getNumOperands());
+    for (const Use &Op : I.operands())
+      addOperand(Op.get());
+  }
+
+  void addFunction(const Function &F) {
+    add(F.getName());
+    addType(F.getFunctionType());
+    add(F.isDeclaration());
+    if (F.isDeclaration())
+      return;
+
+    // Number all local values first: operands may refer to values defined
+    // later, e.g. in phi nodes.
+    LocalNumbers.clear();
+    for (const Argument &Arg : F.args())
+      LocalNumbers[&Arg] = LocalNumbers.size();
+    for (const BasicBlock &BB : F) {
+      LocalNumbers[&BB] = LocalNumbers.size();
+      for (const Instruction &I : BB)
+        LocalNumbers[&I] = LocalNumbers.size();
+    }
+
+    for (const BasicBlock &BB : F) {
+      add(BB.size());
+      for (const Instruction &I : BB)
+        addInstruction(I);
+    }
+  }
+
+  void addGlobal(const GlobalVariable &GV) {
+    add(GV.getName());
+    addType(GV.getValueType());
+    add(GV.isConstant());
+    add(GV.hasInitializer());
+    if (GV.hasInitializer())
+      addConstant(GV.getInitializer());
+  }
+
+  uint64_t get() const {
+    return xxHash64(ArrayRef<uint8_t>(
+        reinterpret_cast<const uint8_t *>(Tokens.data()),
+        Tokens.size() * sizeof(uint64_t)));
+  }
+
+private:
+  SmallVector<uint64_t, 256> Tokens;
+  DenseMap<const Value *, uint64_t> LocalNumbers;
+};
+
+} // namespace
+
+uint64_t llvm::hashFunction(const Function &F) {
+  StructuralHasher Hasher;
+  Hasher.addFunction(F);
+  return Hasher.get();
+}
+
+uint64_t llvm::hashModule(const Module &M) {
+  StructuralHasher Hasher;
+  for (const GlobalVariable &GV : M.globals())
+    Hasher.addGlobal(GV);
+  for (const Function &F : M)
+    Hasher.addFunction(F);
+  return Hasher.get();
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
+
+namespace llvm {
+
+// Structural hashes of IR. They cover opcodes, types, constants, the dataflow
+// and control flow between instructions and the names of globals, but not the
+// names of local values. The results are stable across runs and across
+// LLVMContexts, so they can be used as keys of caches shared between workers.
+// They do depend on the block layout and operand order; run normalizeModule
+// first to hash equivalent modules alike.
+uint64_t hashFunction(const Function &F);
+uint64_t hashModule(const Module &M);
+
+} // namespace llvm
@@ -16,8 +16,6 @@ typedef llvm::function_ref<Value *(BinaryOperator *, Value *, Value *,
 
 typedef llvm::function_ref<void(BasicBlock *, BranchInst *)> BBVisitor;
 
-#define randif(x) if ((x) && whether())
-
 #define add_patten_I(expanders, code)                                          \
   expanders.push_back(                                                         \
       [](Instruction *I, IRBuilder<> &Builder) -> Instruction * { code })
@@ -1,14 +1,40 @@
 #include "Random.h"
+#include "trace/Tracer.h"
 
-ulong RandomSeed;
-std::mt19937 Gen;
+// Every thread owns its generator, so that in-process workers (e.g. parallel
+// reduction) can replay a seed without interfering with each other.
+thread_local ulong RandomSeed;
+thread_local std::mt19937 Gen;
 
 void InstallSeed(ulong Seed) {
   RandomSeed = Seed;
   Gen = std::mt19937(Seed);
 }
 
-uint choose(uint n) {
-  std::uniform_int_distribution<> Distribute(0, n - 1);
-  return Distribute(Gen);
+static uint draw(uint n, std::optional<uint> Idle,
+                 const std::source_location &Loc) {
+  Tracer *T = Tracer::get();
+  std::optional<uint32_t> Replayed;
+  if (T->isOn())
+    Replayed = T->replay(Loc, n, Idle);
+
+  uint Value;
+  if (Replayed)
+    Value = *Replayed;
+  else
+    Value = std::uniform_int_distribution<>(0, n - 1)(Gen);
+
+  if (T->isOn())
+    T->log(Loc, n, Value, Idle);
+  return Value;
+}
+
+uint choose(uint n, const std::source_location &Loc) {
+  return draw(n, std::nullopt, Loc);
 }
+
+bool whetherToMutate(const std::source_location &Loc) {
+  return draw(2, 0, Loc);
+}
+
+bool whetherToSkip(const std::source_location &Loc) { return draw(2, 1, Loc); }
@@ -1,15 +1,29 @@
 #pragma once
 #include <inttypes.h>
 #include <random>
+#include <source_location>
 #include <stdlib.h>
 #include <vector>
 
 void InstallSeed(ulong Seed);
 
 // Use our own random number generator, to avoid interruption from some library
-// calls
-uint choose(uint n);
-static inline bool whether() { return choose(2); }
+// calls. The call site identifies the decision in traces.
+uint choose(uint n,
+            const std::source_location &Loc = std::source_location::current());
+static inline bool
+whether(const std::source_location &Loc = std::source_location::current()) {
+  return choose(2, Loc);
+}
+
+// Like whether(), but tell the tracer that false leaves the code alone, so
+// that the decision can be minimized. The draws are the same as whether(), so
+// recorded seeds keep reproducing.
+bool whetherToMutate(
+    const std::source_location &Loc = std::source_location::current());
+// Like whether(), but true leaves the code alone.
+bool whetherToSkip(
+    const std::source_location &Loc = std::source_location::current());
 
 template <typename Exec> class RandomExecutor {
 public:
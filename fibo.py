@@ -4,7 +4,6 @@ import subprocess
 import os
 import os.path as path
 import tempfile
-import queue
 import argparse
 import re
 from concurrent.futures import ThreadPoolExecutor
@@ -13,8 +12,6 @@ ROOT_DIR = path.dirname(path.abspath(__file__))
 res_dir = path.join(ROOT_DIR, "bench", "experiment1")
 total_dir = path.join(ROOT_DIR, "bench", "total")
 
-deopt_num = 6
-
 seed_file_path = tempfile.NamedTemporaryFile(
     mode='w', delete=False, suffix='.txt').name
 
@@ -36,55 +33,16 @@ parser.add_argument(
 )
 
 
-def getopt(filepath, seq):
-    prog = tempfile.NamedTemporaryFile(
-        mode='w', delete=False, suffix='.ll')
-
-    if len(seq) == 0:
-        os.system(' ' .join(["opt", "-O3", "-S", filepath, "-o", prog.name]))
-        return prog.name
-
-    os.system(' ' .join(
-        ["./phaser",
-         "-s", seed_file_path,
-         "-o", prog.name,
-         "-passes", seq,
-         filepath]))
-
-    os.system(' ' .join(["opt", "-O3", "-S", prog.name, "-o", prog.name]))
-
-    return prog.name
-
-
-def isBetter(filepath, left, right):
-    left_path = getopt(filepath, left)
-    right_path = getopt(filepath, right)
-
-    return os.system(f"./checker --all --perf {left_path} {right_path} | grep OK >/dev/null 2>&1") == 0
-
-
 def ort(filepath: str, k: int, destdir: str):
-    worklist = queue.Queue()
-
-    best_seq = ""
-    worklist.put(best_seq)
-
-    while not worklist.empty():
-        seq = worklist.get()
-        if len(seq) > k:
-            continue
-
-        if len(seq) == k and isBetter(filepath, seq, best_seq):
-            best_seq = seq
-
-        for i in range(deopt_num):
-            new_seq = seq + str(i)
-            worklist.put(new_seq)
-
-    best_path = getopt(filepath, best_seq)
-    subprocess.run(["cp", best_path, f"{destdir}/ort{k}.ll"],  check=True)
-    with open(path.join(destdir, f"ort{k}_seq.txt"), "w+") as f:
-        f.write(best_seq)
+    # Enumerates, optimizes and compares the sequences in-process, and writes
+    # ort{k}.ll, ort{k}_seq.txt and ort{k}_seed.txt to destdir. The sequence
+    # is replayed with ./phaser -passes=<seq> -seed-per-pass -s <seed>.
+    subprocess.run(["./phaser",
+                    "--search=ort",
+                    "-k", str(k),
+                    "-s", seed_file_path,
+                    "-o", destdir,
+                    filepath], check=True)
 
 
 def process_file(filename):